@@ -0,0 +1,406 @@
+/***************************************************************************//**
+
+  @file         ansi.c
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Terminal output with plain ANSI escape sequences (no ncurses).
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>  // read, write
+#include <poll.h>
+#include <signal.h>
+
+#include "ansi.h"
+
+/*
+  Re-printing a few unchanged cells is cheaper than moving the cursor past
+  them, which takes at least 4 bytes.
+ */
+#define MAX_SKIP_REPRINT 3
+
+/*
+  Unknown cursor position or color.
+ */
+#define UNKNOWN -2
+
+/*
+  Box drawing characters.
+ */
+#define BOX_HORIZONTAL 0x2500
+#define BOX_VERTICAL 0x2502
+#define BOX_TOP_LEFT 0x250C
+#define BOX_TOP_RIGHT 0x2510
+#define BOX_BOTTOM_LEFT 0x2514
+#define BOX_BOTTOM_RIGHT 0x2518
+
+#define CELL(s, which, r, c) ((s)->which[(r) * (s)->cols + (c)])
+
+/*
+  What puts the terminal back the way it was: default colors, cursor shown, and
+  the normal screen.
+ */
+#define ANSI_RESTORE "\033[m\033[?25h\033[?1049l"
+
+/*
+  The terminal to put back if the game is killed by Ctrl-C or SIGTERM (ncurses
+  does the same for itself).  Signal handlers can't be given a screen, and
+  there is only one terminal, so this is global.
+ */
+static int ansi_signal_fd = -1;
+static struct termios ansi_signal_saved;
+static struct sigaction ansi_old_int;
+static struct sigaction ansi_old_term;
+
+/*******************************************************************************
+
+                                 Output Buffer
+
+*******************************************************************************/
+
+/*
+  Append bytes to the frame being built.
+ */
+static void ansi_emit(ansi_screen *s, const char *str, size_t len)
+{
+  if (s->len + len > s->cap) {
+    s->cap = 2 * (s->len + len);
+    s->buf = realloc(s->buf, s->cap);
+  }
+  memcpy(s->buf + s->len, str, len);
+  s->len += len;
+}
+
+static void ansi_emits(ansi_screen *s, const char *str)
+{
+  ansi_emit(s, str, strlen(str));
+}
+
+/*
+  Write out the frame, and start a new one.
+ */
+static void ansi_write(ansi_screen *s)
+{
+  size_t done = 0;
+  ssize_t rv;
+  while (done < s->len) {
+    rv = write(s->fd, s->buf + done, s->len - done);
+    if (rv <= 0) {
+      break;
+    }
+    done += rv;
+  }
+  s->bytes += s->len;
+  s->len = 0;
+}
+
+/*
+  Append a code point, encoded as UTF-8.
+ */
+static void ansi_emit_char(ansi_screen *s, uint32_t ch)
+{
+  char utf8[4];
+  if (ch < 0x80) {
+    utf8[0] = ch;
+    ansi_emit(s, utf8, 1);
+  } else if (ch < 0x800) {
+    utf8[0] = 0xC0 | (ch >> 6);
+    utf8[1] = 0x80 | (ch & 0x3F);
+    ansi_emit(s, utf8, 2);
+  } else {
+    utf8[0] = 0xE0 | (ch >> 12);
+    utf8[1] = 0x80 | ((ch >> 6) & 0x3F);
+    utf8[2] = 0x80 | (ch & 0x3F);
+    ansi_emit(s, utf8, 3);
+  }
+}
+
+/*
+  Set the background color, unless the terminal already has it.
+ */
+static void ansi_emit_bg(ansi_screen *s, int bg)
+{
+  char seq[16];
+  if (bg == s->bg) {
+    return;
+  }
+  if (bg == AC_DEFAULT) {
+    ansi_emits(s, "\033[m");
+  } else {
+    sprintf(seq, "\033[4%dm", bg);
+    ansi_emits(s, seq);
+  }
+  s->bg = bg;
+}
+
+/*
+  Move the cursor, as cheaply as we know how.
+ */
+static void ansi_emit_move(ansi_screen *s, int row, int col)
+{
+  char seq[32];
+  int i;
+
+  if (row == s->cursor_row && col == s->cursor_col) {
+    return;
+  }
+  if (row == s->cursor_row && col > s->cursor_col &&
+      col - s->cursor_col <= MAX_SKIP_REPRINT) {
+    // Reprint what's already there, if it's all in the current color.
+    for (i = s->cursor_col; i < col; i++) {
+      if (CELL(s, cur, row, i).bg != s->bg || CELL(s, cur, row, i).ch >= 0x80)
+        break;
+    }
+    if (i == col) {
+      for (i = s->cursor_col; i < col; i++) {
+        ansi_emit_char(s, CELL(s, cur, row, i).ch);
+      }
+      s->cursor_col = col;
+      return;
+    }
+  }
+  if (row == s->cursor_row && col > s->cursor_col) {
+    sprintf(seq, "\033[%dC", col - s->cursor_col);
+  } else if (col == 0) {
+    sprintf(seq, "\033[%dH", row + 1);
+  } else {
+    sprintf(seq, "\033[%d;%dH", row + 1, col + 1);
+  }
+  ansi_emits(s, seq);
+  s->cursor_row = row;
+  s->cursor_col = col;
+}
+
+/*******************************************************************************
+
+                                    Screen
+
+*******************************************************************************/
+
+/*
+  Take over the terminal: raw input on stdin, the alternate screen, and no
+  cursor.  The screen is rows x cols characters.
+ */
+/*
+  Put the terminal back, and then let the signal do whatever it would have done
+  without us (usually end the game).  Only async-signal-safe calls here.
+ */
+static void ansi_on_signal(int sig)
+{
+  ssize_t n = write(ansi_signal_fd, ANSI_RESTORE, sizeof(ANSI_RESTORE) - 1);
+  (void)n;
+  tcsetattr(STDIN_FILENO, TCSANOW, &ansi_signal_saved);
+  sigaction(sig, sig == SIGINT ? &ansi_old_int : &ansi_old_term, NULL);
+  raise(sig);
+}
+
+void ansi_init(ansi_screen *s, int fd, int rows, int cols)
+{
+  struct termios raw;
+  struct sigaction sa;
+
+  s->fd = fd;
+  s->rows = rows;
+  s->cols = cols;
+  s->cur = malloc(rows * cols * sizeof(ansi_cell));
+  s->prev = malloc(rows * cols * sizeof(ansi_cell));
+  s->redraw = true;
+  s->cap = rows * cols * 16;
+  s->buf = malloc(s->cap);
+  s->len = 0;
+  s->cursor_row = UNKNOWN;
+  s->cursor_col = UNKNOWN;
+  s->bg = UNKNOWN;
+  s->bytes = 0;
+  s->frames = 0;
+  ansi_clear(s);
+
+  tcgetattr(STDIN_FILENO, &s->saved);
+  ansi_signal_fd = fd;
+  ansi_signal_saved = s->saved;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = ansi_on_signal;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGINT, &sa, &ansi_old_int);
+  sigaction(SIGTERM, &sa, &ansi_old_term);
+
+  raw = s->saved;
+  raw.c_lflag &= ~(ICANON | ECHO);
+  raw.c_cc[VMIN] = 0;
+  raw.c_cc[VTIME] = 0;
+  tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+
+  ansi_emits(s, "\033[?1049h\033[?25l\033[m\033[2J");
+  s->bg = AC_DEFAULT;
+  ansi_write(s);
+}
+
+/*
+  Give the terminal back the way we found it.
+ */
+void ansi_destroy(ansi_screen *s)
+{
+  ansi_emits(s, ANSI_RESTORE);
+  ansi_write(s);
+  tcsetattr(STDIN_FILENO, TCSANOW, &s->saved);
+  sigaction(SIGINT, &ansi_old_int, NULL);
+  sigaction(SIGTERM, &ansi_old_term, NULL);
+  free(s->cur);
+  free(s->prev);
+  free(s->buf);
+}
+
+/*
+  Blank the whole screen (in memory).
+ */
+void ansi_clear(ansi_screen *s)
+{
+  int i;
+  for (i = 0; i < s->rows * s->cols; i++) {
+    s->cur[i].ch = ' ';
+    s->cur[i].bg = AC_DEFAULT;
+  }
+}
+
+/*
+  Set one cell.  Cells off the screen are ignored.
+ */
+void ansi_put(ansi_screen *s, int row, int col, uint32_t ch, int bg)
+{
+  if (0 <= row && row < s->rows && 0 <= col && col < s->cols) {
+    CELL(s, cur, row, col).ch = ch;
+    CELL(s, cur, row, col).bg = bg;
+  }
+}
+
+/*
+  Write an (ASCII) string, in the default colors.
+ */
+void ansi_text(ansi_screen *s, int row, int col, const char *str)
+{
+  for (; *str; str++, col++) {
+    ansi_put(s, row, col, *str, AC_DEFAULT);
+  }
+}
+
+/*
+  Draw the outline of a box.
+ */
+void ansi_box(ansi_screen *s, int row, int col, int height, int width)
+{
+  int i;
+  for (i = 1; i < width - 1; i++) {
+    ansi_put(s, row, col + i, BOX_HORIZONTAL, AC_DEFAULT);
+    ansi_put(s, row + height - 1, col + i, BOX_HORIZONTAL, AC_DEFAULT);
+  }
+  for (i = 1; i < height - 1; i++) {
+    ansi_put(s, row + i, col, BOX_VERTICAL, AC_DEFAULT);
+    ansi_put(s, row + i, col + width - 1, BOX_VERTICAL, AC_DEFAULT);
+  }
+  ansi_put(s, row, col, BOX_TOP_LEFT, AC_DEFAULT);
+  ansi_put(s, row, col + width - 1, BOX_TOP_RIGHT, AC_DEFAULT);
+  ansi_put(s, row + height - 1, col, BOX_BOTTOM_LEFT, AC_DEFAULT);
+  ansi_put(s, row + height - 1, col + width - 1, BOX_BOTTOM_RIGHT,
+           AC_DEFAULT);
+}
+
+/*
+  Send the changes since the last frame to the terminal, in one write().
+ */
+void ansi_flush(ansi_screen *s)
+{
+  int r, c;
+  ansi_cell *cell, *old;
+
+  for (r = 0; r < s->rows; r++) {
+    for (c = 0; c < s->cols; c++) {
+      cell = &CELL(s, cur, r, c);
+      old = &CELL(s, prev, r, c);
+      if (!s->redraw && cell->ch == old->ch && cell->bg == old->bg) {
+        continue;
+      }
+      ansi_emit_move(s, r, c);
+      ansi_emit_bg(s, cell->bg);
+      ansi_emit_char(s, cell->ch);
+      s->cursor_col++;
+    }
+  }
+
+  // Leave the default color on, in case something else writes to the
+  // terminal.
+  ansi_emit_bg(s, AC_DEFAULT);
+  if (s->len > 0) {
+    ansi_write(s);
+  }
+  memcpy(s->prev, s->cur, s->rows * s->cols * sizeof(ansi_cell));
+  s->redraw = false;
+  s->frames++;
+}
+
+/*******************************************************************************
+
+                                     Input
+
+*******************************************************************************/
+
+/*
+  Read one byte from stdin, waiting for it if block is true.  Returns -1 if
+  there isn't one.
+ */
+static int ansi_getbyte(bool block)
+{
+  unsigned char ch;
+  struct pollfd pfd;
+
+  pfd.fd = STDIN_FILENO;
+  pfd.events = POLLIN;
+  if (poll(&pfd, 1, block ? -1 : 0) <= 0 || read(STDIN_FILENO, &ch, 1) != 1) {
+    return -1;
+  }
+  return ch;
+}
+
+/*
+  Return the next key pressed (see ansi_key), or AK_NONE if there isn't one and
+  block is false.
+ */
+int ansi_getkey(ansi_screen *s, bool block)
+{
+  int ch = ansi_getbyte(block);
+  (void)s;
+
+  if (ch != '\033') {
+    return ch;
+  }
+  // Escape sequences arrive all at once, so don't wait for the rest.
+  ch = ansi_getbyte(false);
+  if (ch == 'O' && ansi_getbyte(false) == 'P') {
+    return AK_F1;
+  } else if (ch != '[') {
+    return AK_NONE;
+  }
+  switch (ansi_getbyte(false)) {
+  case 'A': return AK_UP;
+  case 'B': return AK_DOWN;
+  case 'C': return AK_RIGHT;
+  case 'D': return AK_LEFT;
+  case '1':
+    // "\033[11~" is F1 on some terminals.
+    if (ansi_getbyte(false) == '1' && ansi_getbyte(false) == '~')
+      return AK_F1;
+    return AK_NONE;
+  default:
+    return AK_NONE;
+  }
+}
@@ -0,0 +1,91 @@
+/***************************************************************************//**
+
+  @file         ansi.h
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Terminal output with plain ANSI escape sequences (no ncurses).
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#ifndef ANSI_H
+#define ANSI_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <termios.h>
+
+/*
+  Colors, as numbered by ANSI.  AC_DEFAULT is the terminal's own background.
+ */
+typedef enum {
+  AC_DEFAULT = -1, AC_BLACK, AC_RED, AC_GREEN, AC_YELLOW, AC_BLUE, AC_MAGENTA,
+  AC_CYAN, AC_WHITE
+} ansi_color;
+
+/*
+  Keys that ansi_getkey() understands.  Anything else comes back as itself.
+ */
+typedef enum {
+  AK_NONE = -1, AK_LEFT = 0x100, AK_RIGHT, AK_UP, AK_DOWN, AK_F1
+} ansi_key;
+
+/*
+  One character cell of the screen: a code point and a background color.
+ */
+typedef struct {
+  uint32_t ch;
+  int8_t bg;
+} ansi_cell;
+
+/*
+  A screen is drawn into `cur` in memory.  ansi_flush() compares it with what
+  the terminal is showing (`prev`), and writes only the differences, all in a
+  single write().
+ */
+typedef struct {
+  int fd;
+  int rows;
+  int cols;
+  ansi_cell *cur;
+  ansi_cell *prev;
+  bool redraw;
+  /*
+    Output buffer for a frame, and where the terminal's cursor and background
+    color are (or -2 if we don't know).
+   */
+  char *buf;
+  size_t len;
+  size_t cap;
+  int cursor_row;
+  int cursor_col;
+  int bg;
+  /*
+    Terminal settings to restore afterwards.
+   */
+  struct termios saved;
+  /*
+    Statistics.
+   */
+  long long bytes;
+  long frames;
+} ansi_screen;
+
+void ansi_init(ansi_screen *s, int fd, int rows, int cols);
+void ansi_destroy(ansi_screen *s);
+
+void ansi_clear(ansi_screen *s);
+void ansi_put(ansi_screen *s, int row, int col, uint32_t ch, int bg);
+void ansi_text(ansi_screen *s, int row, int col, const char *str);
+void ansi_box(ansi_screen *s, int row, int col, int height, int width);
+void ansi_flush(ansi_screen *s);
+
+int ansi_getkey(ansi_screen *s, bool block);
+
+#endif // ANSI_H
@@ -0,0 +1,287 @@
+/***************************************************************************//**
+
+  @file         archive.c
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Append-only archive of finished games.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>     // open
+#include <unistd.h>    // pwrite, close
+#include <sys/mman.h>  // mmap
+#include <sys/stat.h>  // fstat
+
+#include "archive.h"
+
+/*
+  Round up to the record alignment.
+ */
+#define TA_ALIGN(x) (((x) + 7) & ~(size_t)7)
+
+/*
+  Return the size of the record for a board of the given size.
+ */
+static size_t ta_record_size(int rows, int cols)
+{
+  return TA_ALIGN(sizeof(tetris_record) + (rows * cols + 1) / 2);
+}
+
+/*
+  Return the path of the index file for an archive.  Caller frees.
+ */
+static char *ta_index_path(const char *path)
+{
+  char *idx = malloc(strlen(path) + sizeof(TA_INDEX_SUFFIX));
+  strcpy(idx, path);
+  strcat(idx, TA_INDEX_SUFFIX);
+  return idx;
+}
+
+/*******************************************************************************
+
+                                   Appending
+
+*******************************************************************************/
+
+/*
+  Open an archive for appending, creating it if it doesn't exist.  Returns NULL
+  on failure, with errno set.
+ */
+tetris_archive *ta_open(const char *path)
+{
+  struct stat st;
+  char *idx = ta_index_path(path);
+  tetris_archive *ta = malloc(sizeof(tetris_archive));
+
+  ta->data = open(path, O_RDWR | O_CREAT, 0644);
+  ta->index = open(idx, O_RDWR | O_CREAT, 0644);
+  free(idx);
+  if (ta->data < 0 || ta->index < 0 || fstat(ta->data, &st) < 0) {
+    goto error;
+  }
+
+  if (st.st_size == 0) {
+    if (pwrite(ta->data, TA_MAGIC, TA_MAGIC_LEN, 0) != TA_MAGIC_LEN) {
+      goto error;
+    }
+    ta->end = TA_MAGIC_LEN;
+  } else {
+    ta->end = TA_ALIGN(st.st_size);
+  }
+
+  if (fstat(ta->index, &st) < 0) {
+    goto error;
+  }
+  ta->count = st.st_size / sizeof(uint64_t);
+  pthread_mutex_init(&ta->lock, NULL);
+  return ta;
+
+ error:
+  if (ta->data >= 0) close(ta->data);
+  if (ta->index >= 0) close(ta->index);
+  free(ta);
+  return NULL;
+}
+
+void ta_close(tetris_archive *ta)
+{
+  pthread_mutex_destroy(&ta->lock);
+  close(ta->data);
+  close(ta->index);
+  free(ta);
+}
+
+/*
+  Append a finished game to the archive.  Only the space for the record is
+  claimed under the lock; the record and its index entry are written outside of
+  it, so appending threads don't wait on each other's I/O.  Returns the game ID,
+  or -1 on failure.
+ */
+long ta_append(tetris_archive *ta, tetris_game *obj, uint32_t seed,
+               uint32_t ticks)
+{
+  int i, j, n;
+  uint64_t offset;
+  uint32_t id;
+  size_t size = ta_record_size(obj->rows, obj->cols);
+  tetris_record *rec = calloc(1, size);
+
+  rec->size = size;
+  rec->seed = seed;
+  rec->ticks = ticks;
+  rec->points = obj->points;
+  rec->level = obj->level;
+  rec->lines_remaining = obj->lines_remaining;
+  rec->rows = obj->rows;
+  rec->cols = obj->cols;
+  rec->falling = obj->falling.typ;
+  rec->next = obj->next.typ;
+  rec->stored = obj->stored.typ;
+  for (i = 0, n = 0; i < obj->rows; i++) {
+    for (j = 0; j < obj->cols; j++, n++) {
+      rec->board[n / 2] |= tg_get(obj, i, j) << (n % 2 ? 0 : 4);
+    }
+  }
+
+  pthread_mutex_lock(&ta->lock);
+  id = ta->count++;
+  offset = ta->end;
+  ta->end += size;
+  pthread_mutex_unlock(&ta->lock);
+
+  rec->id = id;
+  if (pwrite(ta->data, rec, size, offset) != (ssize_t)size) {
+    // Mark the space we claimed as skipped, so readers can get past it to the
+    // records other threads write after it.  If even this fails, it stays
+    // zeros, which readers skip too.
+    memset(rec, 0, sizeof(tetris_record));
+    rec->size = size;
+    rec->id = TA_SKIPPED;
+    pwrite(ta->data, rec, sizeof(tetris_record), offset);
+    free(rec);
+    return -1;
+  }
+  free(rec);
+  if (pwrite(ta->index, &offset, sizeof(offset), id * sizeof(offset))
+      != sizeof(offset)) {
+    return -1;
+  }
+  return id;
+}
+
+/*******************************************************************************
+
+                                    Reading
+
+*******************************************************************************/
+
+/*
+  Map a file read-only, returning NULL if it's empty or can't be mapped.
+ */
+static const void *ta_map_file(const char *path, size_t *size)
+{
+  struct stat st;
+  void *addr;
+  int fd = open(path, O_RDONLY);
+
+  *size = 0;
+  if (fd < 0) {
+    return NULL;
+  }
+  if (fstat(fd, &st) < 0 || st.st_size == 0) {
+    close(fd);
+    return NULL;
+  }
+  addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    return NULL;
+  }
+  *size = st.st_size;
+  return addr;
+}
+
+/*
+  Map an archive for reading.  Records appended after this call aren't seen.
+  Returns 0 on success, -1 on failure.
+ */
+int ta_map(tetris_archive_map *map, const char *path)
+{
+  char *idx = ta_index_path(path);
+
+  map->data = ta_map_file(path, &map->data_size);
+  map->index = ta_map_file(idx, &map->index_size);
+  map->count = map->index_size / sizeof(uint64_t);
+  free(idx);
+
+  if (map->data == NULL || map->data_size < TA_MAGIC_LEN ||
+      memcmp(map->data, TA_MAGIC, TA_MAGIC_LEN) != 0) {
+    ta_unmap(map);
+    return -1;
+  }
+  return 0;
+}
+
+void ta_unmap(tetris_archive_map *map)
+{
+  if (map->data) munmap((void *)map->data, map->data_size);
+  if (map->index) munmap((void *)map->index, map->index_size);
+  map->data = NULL;
+  map->index = NULL;
+  map->count = 0;
+}
+
+/*
+  Return whether there is a complete record at the offset.
+ */
+static bool ta_valid(const tetris_archive_map *map, uint64_t offset)
+{
+  const tetris_record *rec;
+  if (offset < TA_MAGIC_LEN || offset + sizeof(tetris_record) > map->data_size)
+    return false;
+  rec = (const tetris_record *)(map->data + offset);
+  return rec->size >= sizeof(tetris_record) &&
+    offset + rec->size <= map->data_size;
+}
+
+/*
+  Return the record for a game ID, or NULL if there isn't one.
+ */
+const tetris_record *ta_get(const tetris_archive_map *map, uint32_t id)
+{
+  if (id >= map->count || !ta_valid(map, map->index[id]) ||
+      ((const tetris_record *)(map->data + map->index[id]))->id != id) {
+    return NULL;
+  }
+  return (const tetris_record *)(map->data + map->index[id]);
+}
+
+/*
+  Return the record following prev in the data file, or the first one if prev
+  is NULL.  Returns NULL at the end.  Records come in the order they were
+  written, which isn't necessarily ID order.  Gaps left by failed writes are
+  skipped: zeros 8 bytes at a time (records are aligned and never start with a
+  zero size), and skip records by their size.
+ */
+const tetris_record *ta_next(const tetris_archive_map *map,
+                             const tetris_record *prev)
+{
+  const tetris_record *rec;
+  uint64_t offset = TA_MAGIC_LEN;
+  if (prev != NULL) {
+    offset = (const unsigned char *)prev - map->data + prev->size;
+  }
+  while (offset + sizeof(uint32_t) <= map->data_size) {
+    rec = (const tetris_record *)(map->data + offset);
+    if (rec->size == 0) {
+      offset += 8;
+    } else if (!ta_valid(map, offset)) {
+      return NULL;
+    } else if (rec->id == TA_SKIPPED) {
+      offset += rec->size;
+    } else {
+      return rec;
+    }
+  }
+  return NULL;
+}
+
+/*
+  Return the cell at the given row and column of a record's board.
+ */
+char ta_cell(const tetris_record *rec, int row, int col)
+{
+  int n = row * rec->cols + col;
+  return (rec->board[n / 2] >> (n % 2 ? 0 : 4)) & 0xF;
+}
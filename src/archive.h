@@ -0,0 +1,99 @@
+/***************************************************************************//**
+
+  @file         archive.h
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Append-only archive of finished games.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <stddef.h> // for size_t
+#include <stdint.h>
+#include <pthread.h>
+
+#include "tetris.h"
+
+/*
+  An archive is two files.  The data file (at the given path) starts with an
+  8 byte magic string, followed by game records, each aligned to 8 bytes.  The
+  index file (path + ".idx") is an array of 64 bit data file offsets, indexed
+  by game ID.  An offset of zero means the record isn't there (yet).  Both files
+  are only ever appended to.
+
+  Space for a record is claimed before it's written, so a failed write leaves a
+  gap: either zeros, or (if we could still write that much) a record header
+  with the ID TA_SKIPPED.  Readers step over both.
+ */
+#define TA_MAGIC "TGARCHV1"
+#define TA_MAGIC_LEN 8
+#define TA_INDEX_SUFFIX ".idx"
+#define TA_SKIPPED 0xFFFFFFFF
+
+/*
+  A game record, as it sits in the data file.  The board is packed two cells
+  per byte, high nibble first, in row-major order.
+ */
+typedef struct {
+  uint32_t size;  // bytes in the whole record, including padding
+  uint32_t id;
+  uint32_t seed;
+  uint32_t ticks;
+  int32_t points;
+  int16_t level;
+  int16_t lines_remaining;
+  uint16_t rows;
+  uint16_t cols;
+  int8_t falling;
+  int8_t next;
+  int8_t stored;
+  uint8_t reserved;
+  uint8_t board[];
+} tetris_record;
+
+/*
+  An archive opened for appending.  Any number of threads may append to it at
+  once.
+ */
+typedef struct {
+  int data;
+  int index;
+  pthread_mutex_t lock;
+  uint64_t end;
+  uint32_t count;
+} tetris_archive;
+
+/*
+  A read-only view of an archive, memory mapped.  Records are read in place.
+ */
+typedef struct {
+  const unsigned char *data;
+  size_t data_size;
+  const uint64_t *index;
+  size_t index_size;
+  uint32_t count;
+} tetris_archive_map;
+
+// Appending.
+tetris_archive *ta_open(const char *path);
+void ta_close(tetris_archive *ta);
+long ta_append(tetris_archive *ta, tetris_game *obj, uint32_t seed,
+               uint32_t ticks);
+
+// Reading.
+int ta_map(tetris_archive_map *map, const char *path);
+void ta_unmap(tetris_archive_map *map);
+const tetris_record *ta_get(const tetris_archive_map *map, uint32_t id);
+const tetris_record *ta_next(const tetris_archive_map *map,
+                             const tetris_record *prev);
+char ta_cell(const tetris_record *rec, int row, int col);
+
+#endif // ARCHIVE_H
@@ -0,0 +1,173 @@
+/***************************************************************************//**
+
+  @file         audio.c
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Music and sound effects.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#if WITH_SDL
+# include <SDL/SDL.h>
+# include <SDL/SDL_mixer.h>
+#endif
+
+#include "audio.h"
+
+#if WITH_SDL
+
+/*
+  Files to load.  None of them have to exist.
+ */
+#define MUSIC_FILE "tetris.mp3"
+static const char *EFFECT_FILES[NUM_EFFECTS] = {
+  "clear.wav", "lock.wav", "level.wav"
+};
+
+/*
+  Audio is set up on its own thread, so the game can start right away.  Until
+  `ready` is set, there is no sound.  Once it is, everything below is only
+  read, so the game thread doesn't need a lock.
+ */
+static pthread_t loader;
+static bool started = false;
+static int ready = false;
+static const char *error = NULL;
+static Mix_Music *music = NULL;
+
+/*
+  The effects are decoded when they're loaded, and each has its own mixer
+  channel, so playing one doesn't allocate anything or wait for a free channel.
+  Playing an effect again just restarts it.
+ */
+static Mix_Chunk *effects[NUM_EFFECTS];
+
+/*
+  Thread body: open the audio device, load everything, and start the music.
+ */
+static void *audio_load(void *arg)
+{
+  int i;
+  (void)arg;
+
+  if (SDL_Init(SDL_INIT_AUDIO) < 0) {
+    error = "unable to initialize SDL";
+    return NULL;
+  }
+  if (Mix_Init(MIX_INIT_MP3) != MIX_INIT_MP3) {
+    error = "unable to initialize SDL_mixer";
+    return NULL;
+  }
+  if (Mix_OpenAudio(MIX_DEFAULT_FREQUENCY, MIX_DEFAULT_FORMAT, 2, 1024) != 0) {
+    error = "unable to initialize audio";
+    return NULL;
+  }
+  Mix_AllocateChannels(NUM_EFFECTS); // music doesn't need a channel
+
+  for (i = 0; i < NUM_EFFECTS; i++) {
+    effects[i] = Mix_LoadWAV(EFFECT_FILES[i]);
+  }
+  music = Mix_LoadMUS(MUSIC_FILE);
+  if (music) {
+    Mix_PlayMusic(music, -1);
+  }
+
+  __atomic_store_n(&ready, true, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+/*
+  Return true if audio has finished loading.
+ */
+static bool audio_ready(void)
+{
+  return __atomic_load_n(&ready, __ATOMIC_ACQUIRE);
+}
+
+/*
+  Start loading audio in the background.
+ */
+void audio_start(void)
+{
+  started = pthread_create(&loader, NULL, audio_load, NULL) == 0;
+}
+
+/*
+  Stop all sound and free everything.  Waits for loading to finish, if it
+  hasn't yet.
+ */
+void audio_stop(void)
+{
+  int i;
+  if (!started) {
+    return;
+  }
+  pthread_join(loader, NULL);
+  started = false;
+
+  if (error) {
+    fprintf(stderr, "%s\n", error);
+  }
+  if (!audio_ready()) {
+    SDL_Quit();
+    return;
+  }
+
+  Mix_HaltMusic();
+  Mix_HaltChannel(-1);
+  if (music) {
+    Mix_FreeMusic(music);
+  }
+  for (i = 0; i < NUM_EFFECTS; i++) {
+    if (effects[i]) {
+      Mix_FreeChunk(effects[i]);
+    }
+  }
+  Mix_CloseAudio();
+  Mix_Quit();
+  SDL_Quit();
+}
+
+void audio_pause(void)
+{
+  if (audio_ready()) {
+    Mix_PauseMusic();
+  }
+}
+
+void audio_resume(void)
+{
+  if (audio_ready()) {
+    Mix_ResumeMusic();
+  }
+}
+
+/*
+  Play a sound effect, if it's loaded.
+ */
+void audio_play(audio_effect effect)
+{
+  if (audio_ready() && effects[effect]) {
+    Mix_PlayChannel(effect, effects[effect], 0);
+  }
+}
+
+#else // WITH_SDL
+
+void audio_start(void) {}
+void audio_stop(void) {}
+void audio_pause(void) {}
+void audio_resume(void) {}
+void audio_play(audio_effect effect) { (void)effect; }
+
+#endif // WITH_SDL
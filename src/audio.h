@@ -0,0 +1,36 @@
+/***************************************************************************//**
+
+  @file         audio.h
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Music and sound effects.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#ifndef AUDIO_H
+#define AUDIO_H
+
+/*
+  Sound effects.
+ */
+typedef enum {
+  SFX_CLEAR, SFX_LOCK, SFX_LEVEL
+} audio_effect;
+#define NUM_EFFECTS 3
+
+/*
+  Without WITH_SDL, these all do nothing.
+ */
+void audio_start(void);
+void audio_stop(void);
+void audio_pause(void);
+void audio_resume(void);
+void audio_play(audio_effect effect);
+
+#endif // AUDIO_H
@@ -0,0 +1,180 @@
+/***************************************************************************//**
+
+  @file         autosave.c
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Saving the game in the background.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "autosave.h"
+#include "util.h"
+
+/*
+  Sync the directory holding `path`, so that a rename into it is on disk too.
+ */
+static void as_sync_dir(const char *path)
+{
+  char *dir = strdup(path), *slash = strrchr(dir, '/');
+  int fd;
+
+  if (slash == NULL) {
+    strcpy(dir, ".");
+  } else if (slash == dir) {
+    slash[1] = '\0';
+  } else {
+    *slash = '\0';
+  }
+  if ((fd = open(dir, O_RDONLY)) >= 0) {
+    fsync(fd);
+    close(fd);
+  }
+  free(dir);
+}
+
+/*
+  Write one snapshot to the save file.  Returns an error message, or NULL.
+ */
+static const char *as_write(tetris_autosave *as, tetris_game *obj)
+{
+  FILE *f = fopen(as->tmp_path, "w");
+  if (f == NULL) {
+    return "autosave: can't create temporary file";
+  }
+  tg_save(obj, f);
+  if (fflush(f) != 0 || fsync(fileno(f)) != 0) {
+    fclose(f);
+    return "autosave: can't write temporary file";
+  }
+  fclose(f);
+  if (rename(as->tmp_path, as->path) != 0) {
+    unlink(as->tmp_path);
+    return "autosave: can't rename temporary file";
+  }
+  as_sync_dir(as->path);
+  return NULL;
+}
+
+/*
+  Writer thread body: write snapshots as they come, until told to stop.  Any
+  snapshot still pending when it's stopped is written first.
+ */
+static void *as_writer(void *arg)
+{
+  tetris_autosave *as = arg;
+  const char *error;
+
+  pthread_mutex_lock(&as->lock);
+  for (;;) {
+    while (as->pending < 0 && !as->stop) {
+      pthread_cond_wait(&as->wake, &as->lock);
+    }
+    if (as->pending < 0) {
+      break;
+    }
+    as->writing = as->pending;
+    as->pending = -1;
+    pthread_mutex_unlock(&as->lock);
+
+    error = as_write(as, as->snapshots + as->writing);
+
+    pthread_mutex_lock(&as->lock);
+    as->writing = -1;
+    if (error && !as->error) {
+      as->error = error;
+    } else if (!error) {
+      as->saves++;
+    }
+  }
+  pthread_mutex_unlock(&as->lock);
+  return NULL;
+}
+
+/*
+  Start autosaving games like `obj` (same size) to `path`.
+ */
+void as_init(tetris_autosave *as, tetris_game *obj, const char *path)
+{
+  int i;
+
+  as->path = strdup(path);
+  as->tmp_path = malloc(strlen(path) + 5);
+  sprintf(as->tmp_path, "%s.tmp", path);
+  for (i = 0; i < 2; i++) {
+    tg_init_seed(as->snapshots + i, obj->rows, obj->cols, 1);
+  }
+  pthread_mutex_init(&as->lock, NULL);
+  pthread_cond_init(&as->wake, NULL);
+  as->pending = -1;
+  as->writing = -1;
+  as->stop = false;
+  as->saves = 0;
+  as->worst_micros = 0;
+  as->error = NULL;
+  pthread_create(&as->writer, NULL, as_writer, as);
+}
+
+/*
+  Stop autosaving.  Waits for the last snapshot taken to be written.
+ */
+void as_destroy(tetris_autosave *as)
+{
+  int i;
+
+  pthread_mutex_lock(&as->lock);
+  as->stop = true;
+  pthread_cond_signal(&as->wake);
+  pthread_mutex_unlock(&as->lock);
+  pthread_join(as->writer, NULL);
+
+  pthread_cond_destroy(&as->wake);
+  pthread_mutex_destroy(&as->lock);
+  for (i = 0; i < 2; i++) {
+    tg_destroy(as->snapshots + i);
+  }
+  free(as->path);
+  free(as->tmp_path);
+}
+
+/*
+  Take a snapshot of the game, for the writer thread to save.  This only copies
+  the game, so it doesn't make the game thread wait for the disk.
+ */
+void as_snapshot(tetris_autosave *as, tetris_game *obj)
+{
+  long start = clock_micro(), elapsed;
+  int buffer;
+
+  // Fill whichever buffer isn't being written.  Taking it out of `pending`
+  // keeps the writer from picking it up half copied.
+  pthread_mutex_lock(&as->lock);
+  buffer = as->writing == 0 ? 1 : 0;
+  as->pending = -1;
+  pthread_mutex_unlock(&as->lock);
+
+  tg_copy(as->snapshots + buffer, obj);
+
+  pthread_mutex_lock(&as->lock);
+  as->pending = buffer;
+  pthread_cond_signal(&as->wake);
+  pthread_mutex_unlock(&as->lock);
+
+  elapsed = clock_micro() - start;
+  if (elapsed > as->worst_micros) {
+    as->worst_micros = elapsed;
+  }
+}
@@ -0,0 +1,63 @@
+/***************************************************************************//**
+
+  @file         autosave.h
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Saving the game in the background.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#ifndef AUTOSAVE_H
+#define AUTOSAVE_H
+
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "tetris.h"
+
+/*
+  An autosaver writes snapshots of a game on its own thread, so the game thread
+  only has to copy the game.  There are two snapshot buffers: the writer thread
+  reads one while the game thread fills the other.  If a new snapshot comes
+  before the last one was written, it just replaces it.
+
+  Each save is written to "<path>.tmp", synced to disk, and then renamed over
+  the path, so the save file is always either the old game or the new one.
+ */
+typedef struct {
+  char *path;
+  char *tmp_path;
+  tetris_game snapshots[2];
+  /*
+    Protected by `lock`: the snapshot waiting to be written, and the one being
+    written (-1 for none).
+   */
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  int pending;
+  int writing;
+  bool stop;
+  pthread_t writer;
+  /*
+    Statistics: snapshots written, and the longest the game thread spent taking
+    one, in microseconds.
+   */
+  long saves;
+  long worst_micros;
+  /*
+    The first error the writer thread hit, or NULL.
+   */
+  const char *error;
+} tetris_autosave;
+
+void as_init(tetris_autosave *as, tetris_game *obj, const char *path);
+void as_destroy(tetris_autosave *as);
+void as_snapshot(tetris_autosave *as, tetris_game *obj);
+
+#endif // AUTOSAVE_H
@@ -0,0 +1,213 @@
+/***************************************************************************//**
+
+  @file         bot.c
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        A simple heuristic player, for headless simulation.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+#include "bot.h"
+
+/*
+  Give up on reaching the target and just drop after this many moves.
+ */
+#define MAX_MOVES 16
+
+/*
+  Weights for the placement heuristic.
+ */
+#define W_HEIGHT -0.51
+#define W_LINES   0.76
+#define W_HOLES  -0.36
+#define W_BUMPS  -0.18
+
+/*
+  Copy the board into the bot's grid, leaving out the falling block.
+ */
+static void bot_copy_board(tetris_bot *bot, tetris_game *obj)
+{
+  int i, j;
+  tetris_location cell;
+  for (i = 0; i < bot->rows; i++) {
+    for (j = 0; j < bot->cols; j++) {
+      bot->grid[i * bot->cols + j] = tg_get(obj, i, j);
+    }
+  }
+  for (i = 0; i < TETRIS; i++) {
+    cell = TETROMINOS[obj->falling.typ][obj->falling.ori][i];
+    cell.row += obj->falling.loc.row;
+    cell.col += obj->falling.loc.col;
+    if (tg_check(obj, cell.row, cell.col)) {
+      bot->grid[cell.row * bot->cols + cell.col] = TC_EMPTY;
+    }
+  }
+}
+
+/*
+  Check whether a block fits into the bot's grid.
+ */
+static bool bot_fits(tetris_bot *bot, tetris_block block)
+{
+  int i, r, c;
+  for (i = 0; i < TETRIS; i++) {
+    tetris_location cell = TETROMINOS[block.typ][block.ori][i];
+    r = block.loc.row + cell.row;
+    c = block.loc.col + cell.col;
+    if (r < 0 || r >= bot->rows || c < 0 || c >= bot->cols ||
+        TC_IS_FILLED(bot->grid[r * bot->cols + c])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+  Score the grid as it would be after clearing full lines.  Higher is better.
+ */
+static double bot_evaluate(tetris_bot *bot)
+{
+  int i, j, row, lines = 0, holes = 0, height = 0, bumps = 0;
+  int heights[bot->cols];
+  bool full;
+
+  for (j = 0; j < bot->cols; j++) {
+    heights[j] = 0;
+  }
+
+  // Walk from the bottom up, skipping full rows, as if they were cleared.
+  row = 0;
+  for (i = bot->rows - 1; i >= 0; i--) {
+    full = true;
+    for (j = 0; j < bot->cols; j++) {
+      if (TC_IS_EMPTY(bot->grid[i * bot->cols + j])) {
+        full = false;
+        break;
+      }
+    }
+    if (full) {
+      lines++;
+      continue;
+    }
+    row++;
+    for (j = 0; j < bot->cols; j++) {
+      if (TC_IS_FILLED(bot->grid[i * bot->cols + j])) {
+        holes += row - 1 - heights[j];
+        heights[j] = row;
+      }
+    }
+  }
+
+  for (j = 0; j < bot->cols; j++) {
+    height += heights[j];
+    if (j > 0) {
+      bumps += abs(heights[j] - heights[j-1]);
+    }
+  }
+  return W_HEIGHT * height + W_LINES * lines + W_HOLES * holes +
+    W_BUMPS * bumps;
+}
+
+/*
+  Place a block into the grid with the given cell value.
+ */
+static void bot_put(tetris_bot *bot, tetris_block block, char value)
+{
+  int i;
+  for (i = 0; i < TETRIS; i++) {
+    tetris_location cell = TETROMINOS[block.typ][block.ori][i];
+    bot->grid[(block.loc.row + cell.row) * bot->cols + block.loc.col +
+              cell.col] = value;
+  }
+}
+
+/*
+  Choose the best orientation and column for the falling block.
+ */
+static void bot_plan(tetris_bot *bot, tetris_game *obj)
+{
+  int ori, col;
+  double score, best = -DBL_MAX;
+  tetris_block block;
+
+  bot_copy_board(bot, obj);
+  bot->ori = obj->falling.ori;
+  bot->col = obj->falling.loc.col;
+  bot->moves = 0;
+
+  for (ori = 0; ori < NUM_ORIENTATIONS; ori++) {
+    for (col = -TETRIS + 1; col < bot->cols; col++) {
+      block = obj->falling;
+      block.ori = ori;
+      block.loc.col = col;
+      if (!bot_fits(bot, block)) {
+        continue;
+      }
+      while (bot_fits(bot, block)) {
+        block.loc.row++;
+      }
+      block.loc.row--;
+
+      bot_put(bot, block, TYPE_TO_CELL(block.typ));
+      score = bot_evaluate(bot);
+      bot_put(bot, block, TC_EMPTY);
+
+      if (score > best) {
+        best = score;
+        bot->ori = ori;
+        bot->col = col;
+      }
+    }
+  }
+}
+
+/*
+  Set up a bot to play the given game.
+ */
+void bot_init(tetris_bot *bot, tetris_game *obj)
+{
+  bot->rows = obj->rows;
+  bot->cols = obj->cols;
+  bot->grid = malloc(obj->rows * obj->cols);
+  bot->planned.typ = -1;
+}
+
+void bot_destroy(tetris_bot *bot)
+{
+  free(bot->grid);
+}
+
+/*
+  Return the next move the bot would like to make.
+ */
+tetris_move bot_move(tetris_bot *bot, tetris_game *obj)
+{
+  tetris_block *f = &obj->falling;
+
+  if (f->typ != bot->planned.typ || (obj->events & TE_LOCK)) {
+    bot_plan(bot, obj);
+    bot->planned = *f;
+  }
+
+  if (bot->moves++ >= MAX_MOVES) {
+    return TM_DROP;
+  } else if (f->ori != bot->ori) {
+    return TM_CLOCK;
+  } else if (f->loc.col > bot->col) {
+    return TM_LEFT;
+  } else if (f->loc.col < bot->col) {
+    return TM_RIGHT;
+  } else {
+    return TM_DROP;
+  }
+}
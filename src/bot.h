@@ -0,0 +1,51 @@
+/***************************************************************************//**
+
+  @file         bot.h
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        A simple heuristic player, for headless simulation.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#ifndef BOT_H
+#define BOT_H
+
+#include "tetris.h"
+
+/*
+  A bot picks a placement (orientation and column) for each new falling block,
+  and then issues one move per tick until the block gets there.
+ */
+typedef struct {
+  /*
+    Scratch copy of the board, without the falling block.
+   */
+  char *grid;
+  int rows;
+  int cols;
+  /*
+    The falling block the current plan was made for.
+   */
+  tetris_block planned;
+  /*
+    Where the bot wants to put it.
+   */
+  int ori;
+  int col;
+  /*
+    Moves made toward the target.  Used to give up and drop when stuck.
+   */
+  int moves;
+} tetris_bot;
+
+void bot_init(tetris_bot *bot, tetris_game *obj);
+void bot_destroy(tetris_bot *bot);
+tetris_move bot_move(tetris_bot *bot, tetris_game *obj);
+
+#endif // BOT_H
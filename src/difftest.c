@@ -0,0 +1,493 @@
+/***************************************************************************//**
+
+  @file         difftest.c
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Differential tester: tetris.c against the frozen reference.
+
+  Plays the same move streams through tetris.c and reference.c in lock-step,
+  and compares the whole game state after every tick.  On the first difference,
+  the move stream is shrunk to a small one that still shows it, and printed (or
+  saved with -o) so it can be replayed with -f.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>  // getopt
+
+#include "tetris.h"
+#include "reference.h"
+#include "bot.h"
+#include "rewind.h"
+#include "util.h"
+
+/*
+  Kinds of move streams.
+ */
+typedef enum {
+  ST_RANDOM, // any move, uniformly
+  ST_IDLE,   // mostly long runs of nothing, so blocks fall and lock by gravity
+  ST_BOT,    // the bot playing, with some random moves mixed in
+  NUM_STREAMS
+} stream_kind;
+
+/*
+  A game to play through both engines: its setup, and the moves for each tick.
+ */
+typedef struct {
+  int rows;
+  int cols;
+  uint32_t seed;
+  int rotation;
+  int nmoves;
+  char *moves;
+} stream;
+
+/*
+  What went wrong, when the engines disagree.
+ */
+typedef struct {
+  int tick;
+  char what[128];
+} divergence;
+
+/*
+  The tester's own random numbers, for generating streams.
+ */
+static uint32_t dt_rng = 1;
+
+static uint32_t dt_random(void)
+{
+  dt_rng ^= dt_rng << 13;
+  dt_rng ^= dt_rng >> 17;
+  dt_rng ^= dt_rng << 5;
+  return dt_rng;
+}
+
+/*
+  Compare the two engines after a tick.  Returns false and describes the first
+  difference if they disagree.
+ */
+static bool compare(tetris_game *a, bool a_running, ref_game *b,
+                    bool b_running, divergence *d)
+{
+  int i, j;
+
+#define FIELD(name, x, y)                                               \
+  if ((x) != (y)) {                                                     \
+    snprintf(d->what, sizeof(d->what), "%s: %d (reference %d)", name,   \
+             (int)(x), (int)(y));                                       \
+    return false;                                                       \
+  }
+#define BLOCK(name, x, y)                       \
+  FIELD(name ".typ", (x).typ, (y).typ);         \
+  FIELD(name ".ori", (x).ori, (y).ori);         \
+  FIELD(name ".row", (x).loc.row, (y).loc.row); \
+  FIELD(name ".col", (x).loc.col, (y).loc.col);
+
+  FIELD("running", a_running, b_running);
+  FIELD("rows", a->rows, b->rows);
+  FIELD("cols", a->cols, b->cols);
+  FIELD("points", a->points, b->points);
+  FIELD("level", a->level, b->level);
+  FIELD("lines_remaining", a->lines_remaining, b->lines_remaining);
+  FIELD("lines_cleared", a->lines_cleared, b->lines_cleared);
+  FIELD("events", a->events, b->events);
+  FIELD("gravity_acc", a->gravity_acc, b->gravity_acc);
+  FIELD("rng", a->rng, b->rng);
+  FIELD("rotation", a->rotation, b->rotation);
+  BLOCK("falling", a->falling, b->falling);
+  BLOCK("next", a->next, b->next);
+  BLOCK("stored", a->stored, b->stored);
+
+  for (i = 0; i < a->rows; i++) {
+    for (j = 0; j < a->cols; j++) {
+      if (tg_get(a, i, j) != ref_get(b, i, j)) {
+        snprintf(d->what, sizeof(d->what),
+                 "board[%d][%d]: %d (reference %d)", i, j, tg_get(a, i, j),
+                 ref_get(b, i, j));
+        return false;
+      }
+    }
+  }
+  return true;
+
+#undef BLOCK
+#undef FIELD
+}
+
+/*
+  Return the move to make for the next tick of a generated stream.
+ */
+static tetris_move generate(stream_kind kind, tetris_bot *bot,
+                            tetris_game *obj)
+{
+  uint32_t r = dt_random();
+  switch (kind) {
+  case ST_RANDOM:
+    return r % (TM_NONE + 1);
+  case ST_IDLE:
+    return r % 16 == 0 ? (tetris_move)((r >> 4) % TM_NONE) : TM_NONE;
+  default:
+    // Always ask the bot, so it keeps track of the game.
+    return r % 16 == 0 ? (bot_move(bot, obj), (tetris_move)((r >> 4) % TM_NONE))
+      : bot_move(bot, obj);
+  }
+}
+
+/*
+  Return how many ticks of nothing start at move i.  Generated idle streams get
+  a run of them at once; other streams just play the moves they have.
+ */
+static int idle_run(stream *st, stream_kind kind, int i)
+{
+  int n;
+  if (kind == ST_IDLE) {
+    n = 1 + dt_random() % 64;
+    if (n > st->nmoves - i) {
+      n = st->nmoves - i;
+    }
+    memset(st->moves + i, TM_NONE, n);
+    return n;
+  }
+  if (kind != NUM_STREAMS) {
+    return 1;
+  }
+  for (n = 0; i + n < st->nmoves && st->moves[i + n] == TM_NONE; n++);
+  return n;
+}
+
+/*
+  Play a stream through both engines, until the game ends or the moves run out.
+  With a kind other than NUM_STREAMS, the moves are generated as we go (up to
+  st->nmoves of them), and stored in the stream.  Returns true if the engines
+  agreed the whole way.
+ */
+static bool play(stream *st, stream_kind kind, divergence *d, long *ticks)
+{
+  tetris_game a;
+  ref_game b;
+  tetris_bot bot;
+  bool a_running = true, b_running = true, same = true;
+  tetris_move move;
+  int i, j, run;
+
+  tg_init_seed(&a, st->rows, st->cols, st->seed);
+  ref_init_seed(&b, st->rows, st->cols, st->seed);
+  a.rotation = b.rotation = st->rotation;
+  if (kind == ST_BOT) {
+    bot_init(&bot, &a);
+  }
+
+  for (i = 0; i < st->nmoves && a_running && b_running; i += run) {
+    if (kind == NUM_STREAMS) {
+      move = st->moves[i];
+    } else {
+      move = generate(kind, &bot, &a);
+      st->moves[i] = move;
+    }
+    // Runs of nothing go through tg_idle(), and are compared at the end of what
+    // it did (which may be less than the run, when a block locks).
+    if (move == TM_NONE) {
+      run = tg_idle(&a, idle_run(st, kind, i), &a_running);
+      for (j = 0; j < run && b_running; j++) {
+        b_running = ref_tick(&b, TM_NONE);
+      }
+    } else {
+      a_running = tg_tick(&a, move);
+      b_running = ref_tick(&b, move);
+      run = 1;
+    }
+    if (!compare(&a, a_running, &b, b_running, d)) {
+      d->tick = i + run - 1;
+      i += run;
+      same = false;
+      break;
+    }
+  }
+  if (kind != NUM_STREAMS) {
+    st->nmoves = i;
+  }
+  *ticks += i;
+
+  if (kind == ST_BOT) {
+    bot_destroy(&bot);
+  }
+  tg_destroy(&a);
+  ref_destroy(&b);
+  return same;
+}
+
+/*
+  Shrink a stream that makes the engines disagree, by cutting out runs of moves
+  as long as it still does.
+ */
+static void shrink(stream *st, divergence *d)
+{
+  stream trial = *st;
+  divergence td;
+  long ticks = 0;
+  int chunk, start;
+
+  st->nmoves = d->tick + 1;
+  trial.moves = malloc(st->nmoves);
+  for (chunk = st->nmoves / 2; chunk > 0; chunk /= 2) {
+    for (start = 0; start + chunk <= st->nmoves; ) {
+      memcpy(trial.moves, st->moves, start);
+      memcpy(trial.moves + start, st->moves + start + chunk,
+             st->nmoves - start - chunk);
+      trial.nmoves = st->nmoves - chunk;
+      if (!play(&trial, NUM_STREAMS, &td, &ticks)) {
+        memcpy(st->moves, trial.moves, td.tick + 1);
+        st->nmoves = td.tick + 1;
+        *d = td;
+      } else {
+        start += chunk;
+      }
+    }
+  }
+  free(trial.moves);
+}
+
+/*
+  The rewind check's board and buffer: tall, with few slots, so that ticks that
+  change most rows make the buffer wrap and drop entries all the time.
+ */
+#define RC_ROWS 40
+#define RC_COLS 10
+#define RC_SLOTS 10
+
+/*
+  Compare a game with a copy of it and its board taken earlier.
+ */
+static bool same_game(tetris_game *a, tetris_game *b, char *board,
+                      divergence *d)
+{
+  int i, j;
+  if (a->points != b->points || a->level != b->level ||
+      a->lines_remaining != b->lines_remaining ||
+      a->gravity_acc != b->gravity_acc || a->rng != b->rng ||
+      memcmp(&a->falling, &b->falling, sizeof(tetris_block)) != 0 ||
+      memcmp(&a->next, &b->next, sizeof(tetris_block)) != 0 ||
+      memcmp(&a->stored, &b->stored, sizeof(tetris_block)) != 0) {
+    snprintf(d->what, sizeof(d->what), "header differs");
+    return false;
+  }
+  for (i = 0; i < a->rows; i++) {
+    for (j = 0; j < a->cols; j++) {
+      if (tg_get(a, i, j) != board[i * a->cols + j]) {
+        snprintf(d->what, sizeof(d->what), "board[%d][%d]: %d (was %d)", i,
+                 j, tg_get(a, i, j), board[i * a->cols + j]);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/*
+  Play random moves, recording every tick in a rewind buffer and now and then
+  rewinding, and check that each rewind gives back the game as it was.  Some
+  ticks also scribble over most rows of the board, far more than the buffer
+  has room for on average.  Returns false and describes the first rewind that
+  went wrong.
+ */
+static bool check_rewind(int ticks, long *rewinds, divergence *d)
+{
+  tetris_game g, past[RC_SLOTS];
+  tetris_rewind rw;
+  char boards[RC_SLOTS][RC_ROWS * RC_COLS];
+  int t, i, j, n, want, depth = 0;
+  bool running, ok = true;
+
+  tg_init_seed(&g, RC_ROWS, RC_COLS, dt_random());
+  rw_init(&rw, &g, RC_SLOTS);
+  for (t = 0; t < ticks && ok; t++) {
+    // Remember the game as it is, forgetting what the buffer can't hold.
+    if (depth == RC_SLOTS) {
+      memmove(past, past + 1, (RC_SLOTS - 1) * sizeof(tetris_game));
+      memmove(boards, boards + 1, (RC_SLOTS - 1) * sizeof(boards[0]));
+      depth--;
+    }
+    past[depth] = g;
+    for (i = 0; i < RC_ROWS; i++) {
+      for (j = 0; j < RC_COLS; j++) {
+        boards[depth][i * RC_COLS + j] = tg_get(&g, i, j);
+      }
+    }
+    depth++;
+
+    running = tg_tick(&g, dt_random() % (TM_NONE + 1));
+    if (dt_random() % 3 == 0) {
+      for (n = dt_random() % RC_ROWS; n > 0; n--) {
+        tg_set(&g, dt_random() % RC_ROWS, dt_random() % RC_COLS,
+               dt_random() % (TC_CELLZ + 1));
+      }
+    }
+    rw_record(&rw, &g);
+
+    if (running && dt_random() % 8 != 0) {
+      continue;
+    }
+    // The newest tick can always be undone; older ones may have been dropped.
+    want = 1 + dt_random() % depth;
+    n = rw_rewind(&rw, &g, want);
+    (*rewinds)++;
+    if (n < 1 || n > want) {
+      snprintf(d->what, sizeof(d->what), "undid %d of %d ticks", n, want);
+      ok = false;
+    } else {
+      depth -= n;
+      ok = same_game(&g, &past[depth], boards[depth], d);
+    }
+    d->tick = t;
+  }
+  rw_destroy(&rw);
+  tg_destroy(&g);
+  return ok;
+}
+
+/*
+  Write a stream in the format read_stream() reads.
+ */
+static void write_stream(stream *st, FILE *f)
+{
+  int i;
+  fprintf(f, "rows %d\ncols %d\nseed %u\nrotation %d\nmoves ", st->rows,
+          st->cols, st->seed, st->rotation);
+  for (i = 0; i < st->nmoves; i++) {
+    fputc('0' + st->moves[i], f);
+  }
+  fputc('\n', f);
+}
+
+/*
+  Read a stream saved by write_stream().  Returns false if it's malformed.
+ */
+static bool read_stream(stream *st, FILE *f)
+{
+  int ch, cap = 1024;
+  if (fscanf(f, " rows %d cols %d seed %u rotation %d moves ", &st->rows,
+             &st->cols, &st->seed, &st->rotation) != 4) {
+    return false;
+  }
+  st->moves = malloc(cap);
+  st->nmoves = 0;
+  while ((ch = fgetc(f)) >= '0' && ch <= '0' + TM_NONE) {
+    if (st->nmoves == cap) {
+      cap *= 2;
+      st->moves = realloc(st->moves, cap);
+    }
+    st->moves[st->nmoves++] = ch - '0';
+  }
+  return true;
+}
+
+/*
+  Report a divergence, and save the stream if asked to.
+ */
+static void report(stream *st, divergence *d, const char *out)
+{
+  FILE *f;
+  printf("difftest: engines disagree after tick %d: %s\n", d->tick, d->what);
+  printf("difftest: to reproduce:\n");
+  write_stream(st, stdout);
+  if (out && (f = fopen(out, "w")) != NULL) {
+    write_stream(st, f);
+    fclose(f);
+    printf("difftest: saved to \"%s\"; replay with -f %s\n", out, out);
+  }
+}
+
+static void usage(void)
+{
+  fprintf(stderr, "usage: difftest [-n games] [-m max_ticks] [-s seed] "
+          "[-o repro_file]\n"
+          "       difftest -f repro_file\n");
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+  int games = 1000, max_ticks = 2000, opt, i;
+  long ticks = 0, rewinds = 0;
+  char *out = NULL, *in = NULL;
+  stream st;
+  divergence d;
+  FILE *f;
+
+  while ((opt = getopt(argc, argv, "n:m:s:o:f:")) != -1) {
+    switch (opt) {
+    case 'n': games = atoi(optarg); break;
+    case 'm': max_ticks = atoi(optarg); break;
+    case 's': dt_rng = strtoul(optarg, NULL, 0); break;
+    case 'o': out = optarg; break;
+    case 'f': in = optarg; break;
+    default: usage();
+    }
+  }
+  if (dt_rng == 0 || max_ticks < 1) {
+    usage();
+  }
+
+  // Replay a saved stream.
+  if (in) {
+    if ((f = fopen(in, "r")) == NULL || !read_stream(&st, f)) {
+      fprintf(stderr, "difftest: can't read stream from \"%s\"\n", in);
+      return EXIT_FAILURE;
+    }
+    fclose(f);
+    if (!play(&st, NUM_STREAMS, &d, &ticks)) {
+      report(&st, &d, NULL);
+      return EXIT_FAILURE;
+    }
+    printf("difftest: %ld ticks, engines agree.\n", ticks);
+    return EXIT_SUCCESS;
+  }
+
+  st.moves = malloc(max_ticks);
+  for (i = 0; i < games; i++) {
+    // Mostly normal boards, but some small, odd and tall ones too.
+    if (i % 4 == 0) {
+      st.rows = 4 + dt_random() % 40;
+      st.cols = 4 + dt_random() % 16;
+    } else if (i % 32 == 1) {
+      st.rows = 50 + dt_random() % 150;
+      st.cols = 4 + dt_random() % 8;
+    } else {
+      st.rows = 22;
+      st.cols = 10;
+    }
+    st.seed = dt_random();
+    st.rotation = dt_random() % 2 ? TR_SRS : TR_CLASSIC;
+    st.nmoves = max_ticks;
+    if (!play(&st, i % NUM_STREAMS, &d, &ticks)) {
+      shrink(&st, &d);
+      report(&st, &d, out);
+      return EXIT_FAILURE;
+    }
+  }
+  free(st.moves);
+  printf("difftest: %d games, %ld ticks, engines agree.\n", games, ticks);
+
+  for (i = 0; i < games; i++) {
+    if (!check_rewind(max_ticks / 10, &rewinds, &d)) {
+      printf("difftest: rewind went wrong at tick %d of game %d: %s\n",
+             d.tick, i, d.what);
+      return EXIT_FAILURE;
+    }
+  }
+  printf("difftest: %d games, %ld rewinds, all restored.\n", games, rewinds);
+  return EXIT_SUCCESS;
+}
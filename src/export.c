@@ -0,0 +1,237 @@
+/***************************************************************************//**
+
+  @file         export.c
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Streaming export of placements, as training data.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>     // open
+#include <unistd.h>    // pwrite, close
+
+#include "export.h"
+
+/*
+  Bytes taken by n records, not counting the block header or padding.
+ */
+static size_t tx_columns_size(tetris_export *ex, int n)
+{
+  return n * (sizeof(int32_t) + ex->board_bytes + 6);
+}
+
+/*
+  Point the column pointers of a writer at their places in a block holding n
+  records.
+ */
+static void tx_layout(tetris_export_writer *w, int n)
+{
+  unsigned char *p = w->block + sizeof(tx_block_header);
+  w->points = (int32_t *)p;           p += n * sizeof(int32_t);
+  w->board = p;                       p += n * w->ex->board_bytes;
+  w->falling = (int8_t *)p;           p += n;
+  w->next = (int8_t *)p;              p += n;
+  w->stored = (int8_t *)p;            p += n;
+  w->ori = (int8_t *)p;               p += n;
+  w->col = (int8_t *)p;               p += n;
+  w->lines = p;
+}
+
+/*
+  Create (or truncate) an export file for boards of the given size.  Returns
+  NULL on failure, with errno set.
+ */
+tetris_export *tx_open(const char *path, int rows, int cols)
+{
+  tx_file_header header;
+  tetris_export *ex = malloc(sizeof(tetris_export));
+
+  ex->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (ex->fd < 0) {
+    free(ex);
+    return NULL;
+  }
+  ex->rows = rows;
+  ex->cols = cols;
+  ex->board_bytes = (rows * cols + 7) / 8;
+  ex->end = sizeof(header);
+  ex->records = 0;
+  ex->error = 0;
+  pthread_mutex_init(&ex->lock, NULL);
+
+  memcpy(header.magic, TX_MAGIC, TX_MAGIC_LEN);
+  header.rows = rows;
+  header.cols = cols;
+  header.board_bytes = ex->board_bytes;
+  if (pwrite(ex->fd, &header, sizeof(header), 0) != sizeof(header)) {
+    tx_close(ex);
+    return NULL;
+  }
+  return ex;
+}
+
+/*
+  Return the errno of the first write to the export that failed, or 0.
+ */
+int tx_error(tetris_export *ex)
+{
+  int error;
+  pthread_mutex_lock(&ex->lock);
+  error = ex->error;
+  pthread_mutex_unlock(&ex->lock);
+  return error;
+}
+
+/*
+  Close an export file.  All of its writers should be destroyed first.
+ */
+void tx_close(tetris_export *ex)
+{
+  pthread_mutex_destroy(&ex->lock);
+  close(ex->fd);
+  free(ex);
+}
+
+/*
+  Set up a writer for an export file.  It holds at most `capacity` records in
+  memory (TX_DEFAULT_CAPACITY if zero).
+ */
+void tx_writer_init(tetris_export_writer *w, tetris_export *ex, int capacity)
+{
+  w->ex = ex;
+  w->capacity = capacity > 0 ? capacity : TX_DEFAULT_CAPACITY;
+  w->count = 0;
+  w->block = malloc(sizeof(tx_block_header) + tx_columns_size(ex, w->capacity)
+                    + 8);
+  tx_layout(w, w->capacity);
+}
+
+/*
+  Write out anything left in the writer and free it.
+ */
+void tx_writer_destroy(tetris_export_writer *w)
+{
+  tx_flush(w);
+  free(w->block);
+}
+
+/*
+  Start a record with the state of the game before a placement: the board
+  (without the falling block) and the block types.
+ */
+void tx_begin(tetris_export_writer *w, tetris_game *obj)
+{
+  int i, j, n;
+  uint8_t *board = w->board + w->count * w->ex->board_bytes;
+  tetris_block f = obj->falling;
+
+  memset(board, 0, w->ex->board_bytes);
+  for (i = 0, n = 0; i < obj->rows; i++) {
+    for (j = 0; j < obj->cols; j++, n++) {
+      if (TC_IS_FILLED(tg_get(obj, i, j))) {
+        board[n / 8] |= 1 << (n % 8);
+      }
+    }
+  }
+  for (i = 0; i < TETRIS; i++) {
+    tetris_location cell = TETROMINOS[f.typ][f.ori][i];
+    if (tg_check(obj, f.loc.row + cell.row, f.loc.col + cell.col)) {
+      n = (f.loc.row + cell.row) * obj->cols + f.loc.col + cell.col;
+      board[n / 8] &= ~(1 << (n % 8));
+    }
+  }
+
+  w->falling[w->count] = f.typ;
+  w->next[w->count] = obj->next.typ;
+  w->stored[w->count] = obj->stored.typ;
+}
+
+/*
+  Finish the record started by tx_begin(), with where the block went and what
+  it earned.  Writes out the block if it's now full.
+ */
+void tx_end(tetris_export_writer *w, tetris_block placed, int lines,
+            int points)
+{
+  w->ori[w->count] = placed.ori;
+  w->col[w->count] = placed.loc.col;
+  w->lines[w->count] = lines;
+  w->points[w->count] = points;
+  if (++w->count == w->capacity) {
+    tx_flush(w);
+  }
+}
+
+/*
+  Write the records in the writer to the file as one block.  Only claiming the
+  space in the file is done under the lock.  Returns 0 on success, -1 on
+  failure (and the export's error is set, so other writers can stop too).
+ */
+int tx_flush(tetris_export_writer *w)
+{
+  tetris_export *ex = w->ex;
+  tx_block_header *header = (tx_block_header *)w->block;
+  tetris_export_writer packed;
+  uint64_t offset;
+  size_t size;
+  int n = w->count, rv = 0;
+
+  if (n == 0) {
+    return 0;
+  }
+
+  // Move the columns of a partial block together.  Each column only moves
+  // towards the front, so going in order never overwrites one not yet moved.
+  if (n < w->capacity) {
+    packed = *w;
+    tx_layout(&packed, n);
+    memmove(packed.board, w->board, n * ex->board_bytes);
+    memmove(packed.falling, w->falling, n);
+    memmove(packed.next, w->next, n);
+    memmove(packed.stored, w->stored, n);
+    memmove(packed.ori, w->ori, n);
+    memmove(packed.col, w->col, n);
+    memmove(packed.lines, w->lines, n);
+  }
+
+  size = (sizeof(tx_block_header) + tx_columns_size(ex, n) + 7) & ~(size_t)7;
+  memset(w->block + sizeof(tx_block_header) + tx_columns_size(ex, n), 0,
+         size - sizeof(tx_block_header) - tx_columns_size(ex, n));
+  header->count = n;
+  header->size = size;
+
+  pthread_mutex_lock(&ex->lock);
+  offset = ex->end;
+  ex->end += size;
+  ex->records += n;
+  pthread_mutex_unlock(&ex->lock);
+
+  errno = 0;
+  if (pwrite(ex->fd, w->block, size, offset) != (ssize_t)size) {
+    int error = errno ? errno : EIO; // a short write doesn't set errno
+    // Leave an empty block in the space we claimed, so readers can skip it.
+    header->count = 0;
+    pwrite(ex->fd, header, sizeof(tx_block_header), offset);
+    pthread_mutex_lock(&ex->lock);
+    ex->records -= n;
+    if (ex->error == 0) {
+      ex->error = error;
+    }
+    pthread_mutex_unlock(&ex->lock);
+    rv = -1;
+  }
+  w->count = 0;
+  tx_layout(w, w->capacity);
+  return rv;
+}
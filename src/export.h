@@ -0,0 +1,108 @@
+/***************************************************************************//**
+
+  @file         export.h
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Streaming export of placements, as training data.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "tetris.h"
+
+/*
+  An export file holds one record per placement.  It starts with this header,
+  followed by blocks of records.  Each block is a tx_block_header followed by
+  one column per field, each column holding `count` fixed width values:
+
+    int32  points      points scored by the placement
+    uint8  board       occupancy before the placement, one bit per cell, in
+                       row-major order, least significant bit first; each
+                       board takes `board_bytes` bytes
+    int8   falling     type of the block being placed
+    int8   next        type of the next block
+    int8   stored      type of the held block, or -1
+    int8   ori         orientation the block was placed in
+    int8   col         column the block was placed in
+    uint8  lines       lines cleared by the placement
+
+  Blocks are padded to a multiple of 8 bytes.  A block with a count of zero is
+  space left by a write that failed; readers skip it by its size.
+ */
+#define TX_MAGIC "TGEXPRT1"
+#define TX_MAGIC_LEN 8
+
+typedef struct {
+  char magic[TX_MAGIC_LEN];
+  uint16_t rows;
+  uint16_t cols;
+  uint32_t board_bytes;
+} tx_file_header;
+
+typedef struct {
+  uint32_t count;
+  uint32_t size; // bytes in the whole block, including this header
+} tx_block_header;
+
+/*
+  Records per block, unless the writer asks for something else.
+ */
+#define TX_DEFAULT_CAPACITY 8192
+
+/*
+  An export file, shared by all the writers.
+ */
+typedef struct {
+  int fd;
+  int rows;
+  int cols;
+  uint32_t board_bytes;
+  pthread_mutex_t lock;
+  uint64_t end;
+  uint64_t records;
+  int error; // errno of the first failed write, or 0
+} tetris_export;
+
+/*
+  A writer fills one block in memory, and writes it out with a single call
+  when it's full.  Each thread should have its own.
+ */
+typedef struct {
+  tetris_export *ex;
+  int capacity;
+  int count;
+  unsigned char *block;
+  // Columns within the block.
+  int32_t *points;
+  uint8_t *board;
+  int8_t *falling;
+  int8_t *next;
+  int8_t *stored;
+  int8_t *ori;
+  int8_t *col;
+  uint8_t *lines;
+} tetris_export_writer;
+
+tetris_export *tx_open(const char *path, int rows, int cols);
+void tx_close(tetris_export *ex);
+int tx_error(tetris_export *ex);
+
+void tx_writer_init(tetris_export_writer *w, tetris_export *ex, int capacity);
+void tx_writer_destroy(tetris_export_writer *w);
+void tx_begin(tetris_export_writer *w, tetris_game *obj);
+void tx_end(tetris_export_writer *w, tetris_block placed, int lines,
+            int points);
+int tx_flush(tetris_export_writer *w);
+
+#endif // EXPORT_H
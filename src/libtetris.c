@@ -0,0 +1,148 @@
+/***************************************************************************//**
+
+  @file         libtetris.c
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Batches of games, for driving the engine from other languages.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libtetris.h"
+
+/*
+  Start game i of the batch over, with the batch's next seed.
+ */
+static void tb_reset(tetris_batch *batch, int i)
+{
+  tetris_game *obj = batch->games + i;
+  tg_destroy(obj);
+  tg_init_seed(obj, batch->rows, batch->cols, batch->seed++);
+  obj->rotation = batch->rotation;
+}
+
+/*
+  Write one game's observation.
+ */
+static void tb_observe_game(tetris_game *obj, int8_t *obs)
+{
+  int i;
+  obs[TB_FALLING_TYP] = obj->falling.typ;
+  obs[TB_FALLING_ORI] = obj->falling.ori;
+  obs[TB_FALLING_ROW] = obj->falling.loc.row;
+  obs[TB_FALLING_COL] = obj->falling.loc.col;
+  obs[TB_NEXT_TYP] = obj->next.typ;
+  obs[TB_STORED_TYP] = obj->stored.typ;
+  obs[TB_LEVEL] = obj->level;
+  for (i = 0; i < obj->rows; i++) {
+    memcpy(obs + TB_OBS_HEADER + i * obj->cols, tg_row(obj, i), obj->cols);
+  }
+}
+
+/*
+  Create a batch of `count` games.  Game i starts with seed `seed + i`.  Returns
+  NULL if the sizes or rotation system are out of range, or memory runs out.
+ */
+tetris_batch *tb_create(int count, int rows, int cols, int rotation,
+                        uint32_t seed)
+{
+  tetris_batch *batch;
+  int i;
+
+  if (count < 1 || rows < TB_MIN_SIZE || rows > TB_MAX_SIZE ||
+      cols < TB_MIN_SIZE || cols > TB_MAX_SIZE ||
+      (rotation != TR_CLASSIC && rotation != TR_SRS)) {
+    return NULL;
+  }
+  batch = malloc(sizeof(tetris_batch));
+  if (!batch) {
+    return NULL;
+  }
+  batch->games = malloc(count * sizeof(tetris_game));
+  if (!batch->games) {
+    free(batch);
+    return NULL;
+  }
+  batch->count = count;
+  batch->rows = rows;
+  batch->cols = cols;
+  batch->rotation = rotation;
+  batch->seed = seed;
+  for (i = 0; i < count; i++) {
+    tg_init_seed(batch->games + i, rows, cols, batch->seed++);
+    batch->games[i].rotation = rotation;
+  }
+  return batch;
+}
+
+void tb_delete(tetris_batch *batch)
+{
+  int i;
+  for (i = 0; i < batch->count; i++) {
+    tg_destroy(batch->games + i);
+  }
+  free(batch->games);
+  free(batch);
+}
+
+/*
+  Return the size of one game's observation, in bytes.
+ */
+int tb_obs_size(tetris_batch *batch)
+{
+  return TB_OBS_HEADER + batch->rows * batch->cols;
+}
+
+/*
+  Write the observation of every game into `obs`, which holds count *
+  tb_obs_size() bytes.  Use this to get the first observations, before stepping.
+ */
+void tb_observe(tetris_batch *batch, int8_t *obs)
+{
+  int i, size = tb_obs_size(batch);
+  for (i = 0; i < batch->count; i++) {
+    tb_observe_game(batch->games + i, obs + i * size);
+  }
+}
+
+/*
+  Advance every game by one tick, making moves[i] (a tetris_move) in game i.
+  For each game, writes its observation into `obs` (as tb_observe() does), the
+  points it earned into rewards[i], and whether it ended into dones[i].  A game
+  that ends is restarted, and its observation is the first of the new game.
+ */
+void tb_step(tetris_batch *batch, const int8_t *moves, int8_t *obs,
+             float *rewards, uint8_t *dones)
+{
+  int i, points, size = tb_obs_size(batch);
+  tetris_game *obj;
+  tetris_move move;
+
+  for (i = 0; i < batch->count; i++) {
+    obj = batch->games + i;
+    move = moves[i] >= TM_LEFT && moves[i] <= TM_NONE ? moves[i] : TM_NONE;
+    points = obj->points;
+    dones[i] = !tg_tick(obj, move);
+    rewards[i] = obj->points - points;
+    if (dones[i]) {
+      tb_reset(batch, i);
+    }
+    tb_observe_game(obj, obs + i * size);
+  }
+}
+
+/*
+  Return game i of the batch, for anything the observations leave out.
+ */
+tetris_game *tb_game(tetris_batch *batch, int i)
+{
+  return batch->games + i;
+}
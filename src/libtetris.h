@@ -0,0 +1,69 @@
+/***************************************************************************//**
+
+  @file         libtetris.h
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Batches of games, for driving the engine from other languages.
+
+  This is the interface of libtetris.so, which is just the engine (tetris.c)
+  and this batch API: no terminal, no sound, no global state, and nothing is
+  ever printed.  A batch is a fixed number of games that all advance together
+  with one tb_step() call, which writes every game's observation, reward and
+  done flag straight into arrays the caller owns (numpy arrays, say).
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#ifndef LIBTETRIS_H
+#define LIBTETRIS_H
+
+#include <stdint.h>
+
+#include "tetris.h"
+
+/*
+  An observation is tb_obs_size() bytes (int8_t) per game: these header fields,
+  then the board, row by row, as tetris_cell values with the falling block
+  drawn in.  A missing stored block has type -1.
+ */
+enum {
+  TB_FALLING_TYP, TB_FALLING_ORI, TB_FALLING_ROW, TB_FALLING_COL,
+  TB_NEXT_TYP, TB_STORED_TYP, TB_LEVEL,
+  TB_OBS_HEADER // number of header fields, and where the board starts
+};
+
+/*
+  Board dimensions have to fit in an observation byte, and be at least as big
+  as a tetromino (blocks spawn in the top rows, centered).
+ */
+#define TB_MIN_SIZE TETRIS
+#define TB_MAX_SIZE 127
+
+/*
+  A batch of games.  When a game ends, it is restarted right away, with the
+  batch's next seed.
+ */
+typedef struct {
+  int count;
+  int rows;
+  int cols;
+  int rotation;
+  uint32_t seed;
+  tetris_game *games;
+} tetris_batch;
+
+tetris_batch *tb_create(int count, int rows, int cols, int rotation,
+                        uint32_t seed);
+void tb_delete(tetris_batch *batch);
+int tb_obs_size(tetris_batch *batch);
+void tb_observe(tetris_batch *batch, int8_t *obs);
+void tb_step(tetris_batch *batch, const int8_t *moves, int8_t *obs,
+             float *rewards, uint8_t *dones);
+tetris_game *tb_game(tetris_batch *batch, int i);
+
+#endif // LIBTETRIS_H
@@ -13,21 +13,44 @@
 
 *******************************************************************************/
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <time.h>
 #include <ncurses.h>
 #include <string.h>
-
-#if WITH_SDL
-# include <SDL/SDL.h>
-# include <SDL/SDL_mixer.h>
-#endif
+#include <errno.h>
+#include <unistd.h>   // getopt
 
 #include "tetris.h"
 #include "util.h"
+#include "ansi.h"
+#include "audio.h"
+#include "rewind.h"
+#include "autosave.h"
+#include "share.h"
+
+#define MAX(X,Y) ((X) > (Y) ? (X) : (Y))
 
+/*
+  Length of a game tick.  Gravity is measured per tick.
+ */
+#define TICK_MILLIS 10
+/*
+  With rewinding on, remember this many ticks, and go back this many per key
+  press.
+ */
+#define REWIND_TICKS 1000
+#define REWIND_STEP 100
+/*
+  Pressing S saves to SAVE_FILE.  The game is also saved in the background this
+  often, to its own file, so that it can be picked up after a crash.
+ */
+#define SAVE_FILE "tetris.save"
+#define AUTOSAVE_TICKS 500
+#define AUTOSAVE_FILE "tetris.autosave"
 /*
   2 columns per cell makes the game much nicer.
  */
@@ -39,6 +62,29 @@
                        waddch((w),' '|A_REVERSE|COLOR_PAIR(x))
 #define ADD_EMPTY(w) waddch((w), ' '); waddch((w), ' ')
 
+/*
+  When this isn't NULL, the game is drawn with plain ANSI escape sequences
+  instead of ncurses.
+ */
+static ansi_screen *ansi = NULL;
+
+/*
+  Saves the game in the background.
+ */
+static tetris_autosave autosave;
+
+/*
+  With -S, the game is published in shared memory for other processes to watch
+  (and with -i, to play).
+ */
+static tetris_share share;
+static bool sharing = false;
+
+/*
+  Frames drawn, for comparing renderers.
+ */
+static long frames = 0;
+
 /*
   Print the tetris board onto the ncurses window.
  */
@@ -93,16 +139,149 @@ void display_score(WINDOW *w, tetris_game *tg)
   wnoutrefresh(w);
 }
 
+/*
+  Background colors of each cell, for the ANSI renderer.  Same as init_colors().
+ */
+static const int ANSI_COLORS[] = {
+  AC_DEFAULT, AC_CYAN, AC_BLUE, AC_WHITE, AC_YELLOW, AC_GREEN, AC_MAGENTA, AC_RED
+};
+
+/*
+  Draw a cell with the ANSI renderer.
+ */
+void ansi_display_cell(ansi_screen *s, int row, int col, char cell)
+{
+  int i;
+  for (i = 0; i < COLS_PER_CELL; i++) {
+    ansi_put(s, row, col + i, ' ', ANSI_COLORS[(int)cell]);
+  }
+}
+
+/*
+  Draw the tetris board with the ANSI renderer.
+ */
+void ansi_display_board(ansi_screen *s, tetris_game *obj)
+{
+  int i, j;
+  ansi_box(s, 0, 0, obj->rows + 2, COLS_PER_CELL * obj->cols + 2);
+  for (i = 0; i < obj->rows; i++) {
+    for (j = 0; j < obj->cols; j++) {
+      ansi_display_cell(s, 1 + i, 1 + COLS_PER_CELL * j, tg_get(obj, i, j));
+    }
+  }
+}
+
+/*
+  Draw a tetris piece in a box with the ANSI renderer.
+ */
+void ansi_display_piece(ansi_screen *s, int row, int col, tetris_block block)
+{
+  int b;
+  tetris_location c;
+  ansi_box(s, row, col, 6, 10);
+  if (block.typ == -1) {
+    return;
+  }
+  for (b = 0; b < TETRIS; b++) {
+    c = TETROMINOS[block.typ][block.ori][b];
+    ansi_display_cell(s, row + c.row + 1, col + c.col * COLS_PER_CELL + 1,
+                      TYPE_TO_CELL(block.typ));
+  }
+}
+
+/*
+  Draw score information with the ANSI renderer.
+ */
+void ansi_display_score(ansi_screen *s, int row, int col, tetris_game *tg)
+{
+  char str[16];
+  ansi_text(s, row, col, "Score");
+  sprintf(str, "%d", tg->points);
+  ansi_text(s, row + 1, col, str);
+  ansi_text(s, row + 2, col, "Level");
+  sprintf(str, "%d", tg->level);
+  ansi_text(s, row + 3, col, str);
+  ansi_text(s, row + 4, col, "Lines");
+  sprintf(str, "%d", tg->lines_remaining);
+  ansi_text(s, row + 5, col, str);
+}
+
+/*
+  Draw everything, with whichever renderer is in use.
+ */
+void display(tetris_game *tg, WINDOW *board, WINDOW *next, WINDOW *hold,
+             WINDOW *score)
+{
+  int col = COLS_PER_CELL * (tg->cols + 1) + 1;
+  if (ansi) {
+    ansi_clear(ansi);
+    ansi_display_board(ansi, tg);
+    ansi_display_piece(ansi, 0, col, tg->next);
+    ansi_display_piece(ansi, 7, col, tg->stored);
+    ansi_display_score(ansi, 14, col, tg);
+    ansi_flush(ansi);
+  } else {
+    display_board(board, tg);
+    display_piece(next, tg->next);
+    display_piece(hold, tg->stored);
+    display_score(score, tg);
+    doupdate();
+  }
+  frames++;
+}
+
+/*
+  Return the next key pressed, as ncurses would (e.g. KEY_LEFT), or ERR if
+  there isn't one and block is false.
+ */
+int read_key(bool block)
+{
+  int key;
+  if (!ansi) {
+    timeout(block ? -1 : 0);
+    key = getch();
+    timeout(0);
+    return key;
+  }
+  switch ((key = ansi_getkey(ansi, block))) {
+  case AK_NONE:  return ERR;
+  case AK_LEFT:  return KEY_LEFT;
+  case AK_RIGHT: return KEY_RIGHT;
+  case AK_UP:    return KEY_UP;
+  case AK_DOWN:  return KEY_DOWN;
+  case AK_F1:    return KEY_F(1);
+  default:       return key;
+  }
+}
+
+/*
+  Show a message in the middle of the board (and nothing else).
+ */
+void show_message(WINDOW *w, tetris_game *tg, const char *message)
+{
+  int row = tg->rows / 2;
+  int col = MAX((tg->cols * COLS_PER_CELL - (int)strlen(message)) / 2, 0);
+  if (ansi) {
+    ansi_clear(ansi);
+    ansi_box(ansi, 0, 0, tg->rows + 2, COLS_PER_CELL * tg->cols + 2);
+    ansi_text(ansi, row, col, message);
+    ansi_flush(ansi);
+  } else {
+    wclear(w);
+    box(w, 0, 0);
+    wmove(w, row, col);
+    wprintw(w, "%s", message);
+    wrefresh(w);
+  }
+}
+
 /*
   Boss mode!  Make it look like you're doing work.
  */
 void boss_mode(void)
 {
-  clear();
-#if WITH_SDL
-  Mix_PauseMusic();
-#endif
-  printw("user@workstation-312:~/Documents/presentation $ ls -l\n"
+  const char *screen =
+         "user@workstation-312:~/Documents/presentation $ ls -l\n"
          "total 528\n"
          "drwxr-xr-x 2 user users   4096 Jun  9 17:05 .\n"
          "drwxr-xr-x 4 user users   4096 Jun 10 09:52 ..\n"
@@ -117,41 +296,74 @@ void boss_mode(void)
          "-rw-r--r-- 1 user users   9284 Jun  9 17:05 presentation.tex\n"
          "-rw-r--r-- 1 user users    229 Jun  9 16:17 presentation.toc\n"
          "\n"
-         "user@workstation-312:~/Documents/presentation $ ");
-  echo();
-  timeout(-1);
-  while (getch() != KEY_F(1));
-  timeout(0);
-  noecho();
-  clear();
-#if WITH_SDL
-  Mix_ResumeMusic();
-#endif
+         "user@workstation-312:~/Documents/presentation $ ";
+  int row = 0, col = 0;
+
+  audio_pause();
+  if (ansi) {
+    ansi_clear(ansi);
+    for (; *screen; screen++) {
+      if (*screen == '\n') {
+        row++;
+        col = 0;
+      } else {
+        ansi_put(ansi, row, col++, *screen, AC_DEFAULT);
+      }
+    }
+    ansi_flush(ansi);
+    while (read_key(true) != KEY_F(1));
+  } else {
+    clear();
+    printw("%s", screen);
+    echo();
+    timeout(-1);
+    while (getch() != KEY_F(1));
+    timeout(0);
+    noecho();
+    clear();
+  }
+  audio_resume();
 }
 
 /*
-  Save and exit the game.
+  Save and exit the game.  If the save can't be written, say so and keep
+  playing.
  */
 void save(tetris_game *game, WINDOW *w)
 {
-  FILE *f;
+  tetris_autosave manual;
 
-  wclear(w);
-  box(w, 0, 0); // return the border
-  wmove(w, 1, 1);
-  wprintw(w, "Save and exit? [Y/n] ");
-  wrefresh(w);
-  timeout(-1);
-  if (getch() == 'n') {
-    timeout(0);
+  show_message(w, game, "Save and exit? [Y/n]");
+  if (read_key(true) == 'n') {
     return;
   }
-  f = fopen("tetris.save", "w");
-  tg_save(game, f);
-  fclose(f);
+  // The autosaver's writer does the safe write-sync-rename for us, and
+  // stopping it waits for the write.
+  as_init(&manual, game, SAVE_FILE);
+  as_snapshot(&manual, game);
+  as_destroy(&manual);
+  if (manual.error) {
+    show_message(w, game, "Save failed!");
+    read_key(true);
+    return;
+  }
+  // With a real save, the crash recovery one isn't needed any more.
+  as_destroy(&autosave);
+  if (autosave.saves > 0) {
+    unlink(AUTOSAVE_FILE);
+  }
+  if (sharing) {
+    sh_publish(&share, game, share.seg->state.tick, false);
+    sh_close(&share);
+  }
   tg_delete(game);
-  endwin();
-  printf("Game saved to \"tetris.save\".\n");
+  if (ansi) {
+    ansi_destroy(ansi);
+  } else {
+    endwin();
+  }
+  audio_stop();
+  printf("Game saved to \"" SAVE_FILE "\".\n");
   printf("Resume by passing the filename as an argument to this program.\n");
   exit(EXIT_SUCCESS);
 }
@@ -172,6 +384,28 @@ void init_colors(void)
   init_pair(TC_CELLZ, COLOR_RED, COLOR_BLACK);
 }
 
+/*
+  Return how many bytes this process has written so far, or -1 if we can't
+  tell.  ncurses does its own output, so this is how we count its bytes.
+  (Linux only.)
+ */
+long long bytes_written(void)
+{
+  long long bytes = -1;
+  char line[64];
+  FILE *f = fopen("/proc/self/io", "r");
+  if (f == NULL) {
+    return -1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    if (sscanf(line, "wchar: %lld", &bytes) == 1) {
+      break;
+    }
+  }
+  fclose(f);
+  return bytes;
+}
+
 /*
   Main tetris game!
  */
@@ -180,14 +414,54 @@ int main(int argc, char **argv)
   tetris_game *tg;
   tetris_move move = TM_NONE;
   bool running = true;
-  WINDOW *board, *next, *hold, *score;
-#if WITH_SDL
-  Mix_Music *music;
-#endif
+  int opt, rotation = -1;
+  long next_tick, ticks = 0;
+  bool use_ansi = false, stats = false, use_rewind = false;
+  bool share_input = false;
+  char *share_name = NULL;
+  tetris_rewind rewind;
+  long long bytes = 0;
+  ansi_screen screen;
+  WINDOW *board = NULL, *next = NULL, *hold = NULL, *score = NULL;
+
+  while ((opt = getopt(argc, argv, "k:avrS:i")) != -1) {
+    switch (opt) {
+    case 'a':
+      use_ansi = true;
+      break;
+    case 'v':
+      stats = true;
+      break;
+    case 'r':
+      use_rewind = true;
+      break;
+    case 'S':
+      share_name = optarg;
+      break;
+    case 'i':
+      share_input = true;
+      break;
+    case 'k':
+      rotation = parse_rotation(optarg);
+      if (rotation < 0) {
+        fprintf(stderr, "tetris: unknown rotation system \"%s\"\n", optarg);
+        exit(EXIT_FAILURE);
+      }
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-a] [-v] [-r] [-k classic|srs] [-S name [-i]] "
+              "[savefile]\n", argv[0]);
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (share_input && !share_name) {
+    fprintf(stderr, "tetris: -i needs a shared game (-S name)\n");
+    exit(EXIT_FAILURE);
+  }
 
   // Load file if given a filename.
-  if (argc >= 2) {
-    FILE *f = fopen(argv[1], "r");
+  if (optind < argc) {
+    FILE *f = fopen(argv[optind], "r");
     if (f == NULL) {
       perror("tetris");
       exit(EXIT_FAILURE);
@@ -198,56 +472,83 @@ int main(int argc, char **argv)
     // Otherwise create new game.
     tg = tg_create(22, 10);
   }
-
-#if WITH_SDL
-
-  // Initialize music.
-  if (SDL_Init(SDL_INIT_AUDIO) < 0) {
-    fprintf(stderr, "unable to initialize SDL\n");
-    exit(EXIT_FAILURE);
-  }
-  if (Mix_Init(MIX_INIT_MP3) != MIX_INIT_MP3) {
-    fprintf(stderr, "unable to initialize SDL_mixer\n");
-    exit(EXIT_FAILURE);
+  if (rotation >= 0) {
+    tg->rotation = rotation;
   }
-  if (Mix_OpenAudio(MIX_DEFAULT_FREQUENCY, MIX_DEFAULT_FORMAT, 2, 1024) != 0) {
-    fprintf(stderr, "unable to initialize audio\n");
-    exit(EXIT_FAILURE);
+
+  if (use_rewind) {
+    rw_init(&rewind, tg, REWIND_TICKS);
   }
-  Mix_AllocateChannels(1); // only need background music
-  music = Mix_LoadMUS("tetris.mp3");
-  if (music) {
-    Mix_PlayMusic(music, -1);
+  as_init(&autosave, tg, AUTOSAVE_FILE);
+  if (share_name) {
+    if (sh_create(&share, share_name, tg) < 0) {
+      if (errno == EEXIST) {
+        fprintf(stderr, "tetris: a game is already published as %s\n",
+                share_name);
+      } else {
+        perror("tetris");
+      }
+      exit(EXIT_FAILURE);
+    }
+    sharing = true;
   }
 
-#endif
-
-  // NCURSES initialization:
-  initscr();             // initialize curses
-  cbreak();              // pass key presses to program, but not signals
-  noecho();              // don't echo key presses to screen
-  keypad(stdscr, TRUE);  // allow arrow keys
-  timeout(0);            // no blocking on getch()
-  curs_set(0);           // set the cursor to invisible
-  init_colors();         // setup tetris colors
+  // Sound loads in the background, and starts when it's ready.
+  audio_start();
 
-  // Create windows for each section of the interface.
-  board = newwin(tg->rows + 2, 2 * tg->cols + 2, 0, 0);
-  next  = newwin(6, 10, 0, 2 * (tg->cols + 1) + 1);
-  hold  = newwin(6, 10, 7, 2 * (tg->cols + 1) + 1);
-  score = newwin(6, 10, 14, 2 * (tg->cols + 1 ) + 1);
+  if (use_ansi) {
+    // The interface is 20 columns right of the board, and 20 rows tall.
+    ansi_init(&screen, STDOUT_FILENO, MAX(tg->rows + 2, 20),
+              COLS_PER_CELL * (tg->cols + 1) + 11);
+    ansi = &screen;
+  } else {
+    // NCURSES initialization:
+    bytes = bytes_written();
+    initscr();             // initialize curses
+    cbreak();              // pass key presses to program, but not signals
+    noecho();              // don't echo key presses to screen
+    keypad(stdscr, TRUE);  // allow arrow keys
+    timeout(0);            // no blocking on getch()
+    curs_set(0);           // set the cursor to invisible
+    init_colors();         // setup tetris colors
+
+    // Create windows for each section of the interface.
+    board = newwin(tg->rows + 2, 2 * tg->cols + 2, 0, 0);
+    next  = newwin(6, 10, 0, 2 * (tg->cols + 1) + 1);
+    hold  = newwin(6, 10, 7, 2 * (tg->cols + 1) + 1);
+    score = newwin(6, 10, 14, 2 * (tg->cols + 1 ) + 1);
+  }
 
-  // Game loop
+  // Game loop.  Ticks are paced by the clock, so the time spent drawing doesn't
+  // slow the game down.  If we fall behind (e.g. while paused), start over from
+  // now rather than rushing through the missed ticks.
+  next_tick = clock_milli();
   while (running) {
     running = tg_tick(tg, move);
-    display_board(board, tg);
-    display_piece(next, tg->next);
-    display_piece(hold, tg->stored);
-    display_score(score, tg);
-    doupdate();
-    sleep_milli(10);
+    if (use_rewind) {
+      rw_record(&rewind, tg);
+    }
+    if (sharing) {
+      sh_publish(&share, tg, ticks + 1, running);
+    }
+    if (++ticks % AUTOSAVE_TICKS == 0 && running) {
+      as_snapshot(&autosave, tg);
+    }
+    if (tg->events & TE_LEVEL) {
+      audio_play(SFX_LEVEL);
+    } else if (tg->events & TE_CLEAR) {
+      audio_play(SFX_CLEAR);
+    } else if (tg->events & TE_LOCK) {
+      audio_play(SFX_LOCK);
+    }
+    display(tg, board, next, hold, score);
+    next_tick += TICK_MILLIS;
+    if (next_tick < clock_milli()) {
+      next_tick = clock_milli();
+    }
+    sleep_until_milli(next_tick);
 
-    switch (getch()) {
+    switch (read_key(false)) {
     case KEY_LEFT:
       move = TM_LEFT;
       break;
@@ -265,14 +566,8 @@ int main(int argc, char **argv)
       move = TM_NONE;
       break;
     case 'p':
-      wclear(board);
-      box(board, 0, 0);
-      wmove(board, tg->rows/2, (tg->cols*COLS_PER_CELL-6)/2);
-      wprintw(board, "PAUSED");
-      wrefresh(board);
-      timeout(-1);
-      getch();
-      timeout(0);
+      show_message(board, tg, "PAUSED");
+      read_key(true);
       move = TM_NONE;
       break;
     case 'b':
@@ -286,28 +581,63 @@ int main(int argc, char **argv)
     case ' ':
       move = TM_HOLD;
       break;
-    default:
+    case 'r':
+      if (use_rewind) {
+        rw_rewind(&rewind, tg, REWIND_STEP);
+      }
       move = TM_NONE;
+      break;
+    default:
+      // With no key pressed, a move sent through shared memory is played.
+      move = share_input ? sh_take_move(&share) : TM_NONE;
     }
   }
 
-  // Deinitialize NCurses
-  wclear(stdscr);
-  endwin();
-
-#if WITH_SDL
+  if (ansi) {
+    ansi_destroy(ansi);
+  } else {
+    // Deinitialize NCurses
+    wclear(stdscr);
+    endwin();
+    bytes = bytes >= 0 ? bytes_written() - bytes : -1;
+  }
 
   // Deinitialize Sound
-  Mix_HaltMusic();
-  Mix_FreeMusic(music);
-  Mix_CloseAudio();
-  Mix_Quit();
+  audio_stop();
+
+  // The game ended (or was quit without saving), so there's nothing to recover
+  // after all.  Only remove the autosave if this game wrote it.
+  as_destroy(&autosave);
+  if (autosave.error) {
+    fprintf(stderr, "%s\n", autosave.error);
+  }
+  if (autosave.saves > 0) {
+    unlink(AUTOSAVE_FILE);
+  }
 
-#endif
+  if (sharing) {
+    sh_publish(&share, tg, ticks, false); // tell watchers it's over
+    sh_close(&share);
+  }
+
+  if (use_rewind) {
+    rw_destroy(&rewind);
+  }
 
   // Output ending message.
   printf("Game over!\n");
   printf("You finished with %d points on level %d.\n", tg->points, tg->level);
+  if (stats) {
+    if (ansi) {
+      bytes = ansi->bytes;
+    }
+    printf("%s wrote %lld bytes in %ld frames (%.1f bytes/frame).\n",
+           ansi ? "ANSI renderer" : "ncurses", bytes, frames,
+           frames ? (double)bytes / frames : 0.0);
+    printf("Autosaved %ld times; the longest snapshot took %ld us "
+           "(a tick is %d us).\n", autosave.saves, autosave.worst_micros,
+           TICK_MILLIS * 1000);
+  }
 
   // Deinitialize Tetris
   tg_delete(tg);
@@ -0,0 +1,468 @@
+/***************************************************************************//**
+
+  @file         perf.c
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Hardware performance counters for the engine's phases (Linux).
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#define _GNU_SOURCE // syscall
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "perf.h"
+
+__thread tetris_perf *pf_thread = NULL;
+
+/*
+  What each counter is, to perf_event_open().
+ */
+static const struct {
+  uint32_t type;
+  uint64_t config;
+  const char *name;
+} PF_EVENTS[PF_COUNTERS] = {
+  {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, "task-ns"},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions"},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch-misses"},
+  {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+   (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), "L1d-misses"},
+  {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL |
+   (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), "LLC-misses"},
+};
+
+static const char *PF_PHASE_NAMES[PF_PHASES] = {
+  "tg_tick", "gravity", "move", "check_lines", "score", "game_over", "tg_fits"
+};
+
+/*
+  How many empty phases are kept, to find the cost of measuring.  The median is
+  taken, so it's odd.
+ */
+#define PF_SAMPLES 1001
+
+/*
+  Layout of a group read (PERF_FORMAT_GROUP with both times).
+ */
+typedef struct {
+  uint64_t nr;
+  uint64_t enabled;
+  uint64_t running;
+  uint64_t values[PF_COUNTERS];
+} pf_group_read;
+
+/*
+  Read the group into `values`, indexed by pf_counter.  Returns false on error.
+ */
+static bool pf_read_group(const tetris_perf *pf, uint64_t *values,
+                          uint64_t *enabled, uint64_t *running)
+{
+  pf_group_read buf;
+  int i;
+  if (read(pf->fd, &buf, sizeof(buf)) < (ssize_t)(3 * sizeof(uint64_t))) {
+    return false;
+  }
+  for (i = 0; i < PF_COUNTERS; i++) {
+    values[i] = pf->slot[i] >= 0 ? buf.values[pf->slot[i]] : 0;
+  }
+  if (enabled) {
+    *enabled = buf.enabled;
+    *running = buf.running;
+  }
+  return true;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PF_DIRECT 1
+
+static uint64_t pf_rdpmc(uint32_t counter)
+{
+  uint32_t lo, hi;
+  __asm__ volatile("rdpmc" : "=a"(lo), "=d"(hi) : "c"(counter));
+  return (uint64_t)hi << 32 | lo;
+}
+
+static uint64_t pf_rdtsc(void)
+{
+  uint32_t lo, hi;
+  __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+  return (uint64_t)hi << 32 | lo;
+}
+
+/*
+  Read a hardware counter from its mapped page, the way linux/perf_event.h
+  describes: what the kernel saved (offset), plus the counter itself while it's
+  on the CPU.  Also gives how long it has been counting, which is the task
+  clock.  The kernel rewrites the page when the thread is switched, so retry
+  until it's the same before and after.
+ */
+static void pf_read_page(const struct perf_event_mmap_page *pc,
+                         uint64_t *count, uint64_t *running)
+{
+  uint32_t seq, idx;
+  uint16_t width;
+  uint64_t cyc, quot, rem, delta;
+  int64_t pmc;
+  do {
+    seq = __atomic_load_n(&pc->lock, __ATOMIC_ACQUIRE);
+    idx = pc->index;
+    width = pc->pmc_width;
+    *count = pc->offset;
+    *running = pc->time_running;
+    delta = 0;
+    if (pc->cap_user_rdpmc && idx) {
+      pmc = pf_rdpmc(idx - 1) << (64 - width);
+      *count += pmc >> (64 - width);
+      cyc = pf_rdtsc();
+      quot = cyc >> pc->time_shift;
+      rem = cyc & (((uint64_t)1 << pc->time_shift) - 1);
+      delta = pc->time_offset + quot * pc->time_mult +
+        ((rem * pc->time_mult) >> pc->time_shift);
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while (__atomic_load_n(&pc->lock, __ATOMIC_RELAXED) != seq);
+  *running += delta;
+}
+#else
+#define PF_DIRECT 0
+#endif
+
+/*
+  Return true if every hardware counter that's open can be read from its page,
+  and the cycle counter's page can give the task clock.
+ */
+static bool pf_can_read_directly(const tetris_perf *pf)
+{
+#if PF_DIRECT
+  const struct perf_event_mmap_page *pc;
+  int i;
+  for (i = 0; i < PF_COUNTERS; i++) {
+    pc = pf->pages[i];
+    if (i != PF_TASK_CLOCK && pf->slot[i] >= 0 &&
+        (pc == NULL || !pc->cap_user_rdpmc || pc->index == 0)) {
+      return false;
+    }
+  }
+  pc = pf->pages[PF_CYCLES];
+  return pc != NULL && pc->cap_user_time;
+#else
+  (void)pf;
+  return false;
+#endif
+}
+
+/*
+  Read the counters at a phase boundary, into `values` indexed by pf_counter.
+  Returns false on error.
+ */
+static bool pf_read(const tetris_perf *pf, uint64_t *values)
+{
+#if PF_DIRECT
+  uint64_t running;
+  int i;
+  if (pf->direct) {
+    memset(values, 0, PF_COUNTERS * sizeof(uint64_t));
+    for (i = 0; i < PF_COUNTERS; i++) {
+      if (i != PF_TASK_CLOCK && pf->slot[i] >= 0) {
+        pf_read_page(pf->pages[i], &values[i], &running);
+        if (i == PF_CYCLES) {
+          values[PF_TASK_CLOCK] = running;
+        }
+      }
+    }
+    return true;
+  }
+#endif
+  return pf_read_group(pf, values, NULL, NULL);
+}
+
+/*
+  Clear a set of counters, without opening them (e.g. to add others into).
+ */
+void pf_clear(tetris_perf *pf)
+{
+  int i;
+  memset(pf, 0, sizeof(tetris_perf));
+  pf->fd = -1;
+  for (i = 0; i < PF_COUNTERS; i++) {
+    pf->fds[i] = -1;
+    pf->slot[i] = -1;
+  }
+}
+
+static int pf_compare(const void *a, const void *b)
+{
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+/*
+  Start and stop measuring a phase.
+ */
+static void pf_start(tetris_perf *pf, pf_phase phase)
+{
+  pf_read(pf, pf->start[phase]);
+}
+
+static void pf_stop(tetris_perf *pf, pf_phase phase)
+{
+  uint64_t now[PF_COUNTERS];
+  int i;
+  if (pf_read(pf, now)) {
+    for (i = 0; i < PF_COUNTERS; i++) {
+      pf->total[phase][i] += now[i] - pf->start[phase][i];
+    }
+    pf->calls[phase]++;
+  }
+}
+
+/*
+  Measure an empty phase, and keep it in a sample of PF_SAMPLES of them, each
+  as likely to be kept as any other (reservoir sampling).
+ */
+static void pf_sample(tetris_perf *pf)
+{
+  uint64_t before[PF_COUNTERS], after[PF_COUNTERS], n = pf->nsamples++;
+  int i;
+  if (!pf_read(pf, before) || !pf_read(pf, after)) {
+    return;
+  }
+  if (n >= PF_SAMPLES) {
+    pf->rng ^= pf->rng << 13;
+    pf->rng ^= pf->rng >> 17;
+    pf->rng ^= pf->rng << 5;
+    if ((n = pf->rng % (n + 1)) >= PF_SAMPLES) {
+      return;
+    }
+  }
+  for (i = 0; i < PF_COUNTERS; i++) {
+    pf->samples[i * PF_SAMPLES + n] = after[i] - before[i];
+  }
+}
+
+/*
+  Set `cost` to the median of the empty phases sampled, so that the odd
+  preemption or interrupt doesn't skew it.
+ */
+static void pf_median(tetris_perf *pf)
+{
+  uint64_t n = pf->nsamples < PF_SAMPLES ? pf->nsamples : PF_SAMPLES;
+  int i;
+  for (i = 0; i < PF_COUNTERS && n > 0; i++) {
+    qsort(pf->samples + i * PF_SAMPLES, n, sizeof(uint64_t), pf_compare);
+    pf->cost[i] = pf->samples[i * PF_SAMPLES + n / 2];
+  }
+}
+
+/*
+  Open the counters for the calling thread, and make them its current ones.
+  Counters the machine doesn't have are left out.  Returns -1 if none could be
+  opened, with errno set.
+ */
+int pf_open(tetris_perf *pf)
+{
+  struct perf_event_attr attr;
+  long page = sysconf(_SC_PAGESIZE);
+  void *addr;
+  int i, fd;
+
+  pf_clear(pf);
+  for (i = 0; i < PF_COUNTERS; i++) {
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PF_EVENTS[i].type;
+    attr.config = PF_EVENTS[i].config;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+      PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.disabled = pf->fd < 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = syscall(SYS_perf_event_open, &attr, 0, -1, pf->fd, 0);
+    pf->fds[i] = fd;
+    pf->slot[i] = fd < 0 ? -1 : pf->nopen++;
+    if (fd >= 0 && pf->fd < 0) {
+      pf->fd = fd;
+    }
+    if (fd >= 0 && PF_DIRECT && i != PF_TASK_CLOCK) {
+      addr = mmap(NULL, page, PROT_READ, MAP_SHARED, fd, 0);
+      pf->pages[i] = addr == MAP_FAILED ? NULL : addr;
+    }
+  }
+  if (pf->fd < 0) {
+    return -1;
+  }
+  ioctl(pf->fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  pf->direct = pf_can_read_directly(pf);
+  pf->samples = malloc(PF_SAMPLES * PF_COUNTERS * sizeof(uint64_t));
+  pf->rng = 1;
+  pf_thread = pf;
+  return 0;
+}
+
+/*
+  Close a thread's counters.  What they counted stays in `pf`, along with the
+  overhead of counting it.
+ */
+void pf_close(tetris_perf *pf)
+{
+  uint64_t values[PF_COUNTERS];
+  int p, i;
+  if (pf->fd >= 0) {
+    pf_median(pf);
+    free(pf->samples);
+    pf->samples = NULL;
+    for (i = 0; i < PF_COUNTERS; i++) {
+      for (p = 0; p < PF_COUNTED; p++) {
+        pf->overhead[p][i] = pf->calls[p] * pf->cost[i];
+      }
+    }
+    pf_read_group(pf, values, &pf->enabled, &pf->running);
+  }
+  for (i = 0; i < PF_COUNTERS; i++) {
+    if (pf->pages[i]) {
+      munmap(pf->pages[i], sysconf(_SC_PAGESIZE));
+      pf->pages[i] = NULL;
+    }
+    if (pf->fds[i] >= 0) {
+      close(pf->fds[i]);
+    }
+  }
+  pf->fd = -1;
+  if (pf_thread == pf) {
+    pf_thread = NULL;
+  }
+}
+
+/*
+  Mark where a phase begins and ends.  Each tick is measured either whole or
+  part by part, taking turns, and the other kind of phase is skipped.
+ */
+void pf_begin(tetris_perf *pf, pf_phase phase)
+{
+  if (phase == PF_TICK && (pf->parts = ++pf->ticks % 2 == 0)) {
+    pf_sample(pf);
+  }
+  if ((phase != PF_TICK) == pf->parts) {
+    pf_start(pf, phase);
+  }
+}
+
+void pf_end(tetris_perf *pf, pf_phase phase)
+{
+  if ((phase != PF_TICK) == pf->parts) {
+    pf_stop(pf, phase);
+  }
+}
+
+/*
+  Add the counts in `src` to `dst` (e.g. from each thread to a total).  The
+  counters in `dst` needn't be open, just cleared.
+ */
+void pf_add(tetris_perf *dst, const tetris_perf *src)
+{
+  int p, i;
+  for (p = 0; p < PF_PHASES; p++) {
+    for (i = 0; i < PF_COUNTERS; i++) {
+      dst->total[p][i] += src->total[p][i];
+      dst->overhead[p][i] += src->overhead[p][i];
+    }
+    dst->calls[p] += src->calls[p];
+  }
+  for (i = 0; i < PF_COUNTERS; i++) {
+    if (src->slot[i] >= 0) {
+      dst->slot[i] = src->slot[i];
+    }
+  }
+  dst->ticks += src->ticks;
+  dst->direct = src->direct;
+  dst->enabled += src->enabled;
+  dst->running += src->running;
+}
+
+/*
+  Return how many ticks a phase was measured in.
+ */
+static double pf_ticks(const tetris_perf *pf, int phase)
+{
+  if (phase == PF_TICK) {
+    return pf->calls[PF_TICK];
+  }
+  return phase < PF_COUNTED ? pf->ticks - pf->calls[PF_TICK] : pf->ticks;
+}
+
+/*
+  Print the counts per million ticks, phase by phase: for each counter, what
+  was measured, what measuring it cost, and the difference.  Phases that cost
+  more to measure than they measured are marked, since what's left of them is
+  noise.
+ */
+void pf_report(const tetris_perf *pf, FILE *f)
+{
+  double ticks, total, overhead;
+  bool noise = false, missing = false;
+  int p, i;
+
+  if (pf->calls[PF_TICK] == 0 || pf->calls[PF_TICK] == pf->ticks) {
+    fprintf(f, "Too few ticks were counted.\n");
+    return;
+  }
+  fprintf(f, "Per million ticks, from %llu ticks measured whole and %llu part "
+          "by part\n(counters read with %s):\n%-12s %14s\n",
+          (unsigned long long)pf->calls[PF_TICK],
+          (unsigned long long)(pf->ticks - pf->calls[PF_TICK]),
+          pf->direct ? "rdpmc" : "read()", "", "calls");
+  for (p = 0; p < PF_PHASES; p++) {
+    fprintf(f, "%-12s %14.0f\n", PF_PHASE_NAMES[p],
+            pf->calls[p] * 1e6 / pf_ticks(pf, p));
+  }
+  for (i = 0; i < PF_COUNTERS; i++) {
+    if (pf->slot[i] < 0) {
+      missing = true;
+      continue;
+    }
+    fprintf(f, "%-12s %14s %14s %14s\n", PF_EVENTS[i].name, "measured",
+            "overhead", "net");
+    for (p = 0; p < PF_COUNTED; p++) {
+      ticks = pf_ticks(pf, p);
+      total = pf->total[p][i] * 1e6 / ticks;
+      overhead = pf->overhead[p][i] * 1e6 / ticks;
+      fprintf(f, "%-12s %14.0f %14.0f %14.0f%s\n", PF_PHASE_NAMES[p], total,
+              overhead, total - overhead, overhead > total ? " *" : "");
+      noise = noise || overhead > total;
+    }
+  }
+  if (noise) {
+    fprintf(f, "* Measuring this phase costs more than the phase itself, so "
+            "its net is noise.\n");
+  }
+  if (missing) {
+    fprintf(f, "Not available here:");
+    for (i = 0; i < PF_COUNTERS; i++) {
+      if (pf->slot[i] < 0) {
+        fprintf(f, " %s", PF_EVENTS[i].name);
+      }
+    }
+    fputc('\n', f);
+  }
+  if (pf->running < pf->enabled) {
+    fprintf(f, "The counters only ran %.0f%% of the time (too many for the "
+            "CPU at once), so they undercount.\n",
+            100.0 * pf->running / pf->enabled);
+  }
+}
@@ -0,0 +1,109 @@
+/***************************************************************************//**
+
+  @file         perf.h
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Hardware performance counters for the engine's phases.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdio.h> // for FILE
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+  Parts of a tick that are measured.  PF_TICK is the whole of tg_tick(), and
+  the others are its parts.  Phases from PF_COUNTED on are only counted, not
+  measured: tg_fits() is called from inside the other phases, far too often to
+  read the counters around.
+ */
+typedef enum {
+  PF_TICK, PF_GRAVITY, PF_MOVE, PF_LINES, PF_SCORE, PF_GAME_OVER,
+  PF_FITS, PF_PHASES
+} pf_phase;
+#define PF_COUNTED PF_FITS
+
+/*
+  What is counted.  Task clock is a software counter (nanoseconds on the CPU),
+  so it works even where the hardware ones don't, like most virtual machines.
+ */
+typedef enum {
+  PF_TASK_CLOCK, PF_CYCLES, PF_INSTRUCTIONS, PF_BRANCH_MISSES, PF_L1D_MISSES,
+  PF_LLC_MISSES, PF_COUNTERS
+} pf_counter;
+
+/*
+  Counters for one thread, and what they added up to in each phase.  The
+  counters are opened as one group, so they all count over the same instants;
+  slot[] says where each one is in a read of the group (-1 if the machine
+  doesn't have it).  Only user space is counted.
+
+  Phases never nest: every other tick is measured whole (PF_TICK), and the
+  rest part by part (`parts`), so no phase counts the reads around another.
+
+  Where the CPU lets user space read its counters (rdpmc), they are read
+  straight from their mapped pages[] (`direct`), which costs a few cycles.
+  Otherwise each read is a read() of the group, which costs more than most
+  phases.  Either way, the reads count too.  Each tick that is measured part by
+  part also measures an empty phase, and keeps a random sample of them;
+  pf_close() takes the median of those as what measuring costs (`cost`), and
+  that many times its calls as each phase's overhead.  The report shows both.
+ */
+typedef struct {
+  int fd;
+  int fds[PF_COUNTERS];
+  int slot[PF_COUNTERS];
+  void *pages[PF_COUNTERS];
+  bool direct;
+  int nopen;
+  uint64_t start[PF_PHASES][PF_COUNTERS];
+  uint64_t total[PF_PHASES][PF_COUNTERS];
+  uint64_t overhead[PF_PHASES][PF_COUNTERS];
+  uint64_t cost[PF_COUNTERS];
+  uint64_t *samples; // PF_SAMPLES per counter
+  uint64_t nsamples; // measured, kept or not
+  uint32_t rng;
+  uint64_t calls[PF_PHASES];
+  uint64_t ticks; // measured or not
+  bool parts;
+  uint64_t enabled;
+  uint64_t running;
+} tetris_perf;
+
+/*
+  The counters of the calling thread, if it has opened some.
+ */
+extern __thread tetris_perf *pf_thread;
+
+void pf_clear(tetris_perf *pf);
+int pf_open(tetris_perf *pf);
+void pf_close(tetris_perf *pf);
+void pf_begin(tetris_perf *pf, pf_phase phase);
+void pf_end(tetris_perf *pf, pf_phase phase);
+void pf_add(tetris_perf *dst, const tetris_perf *src);
+void pf_report(const tetris_perf *pf, FILE *f);
+
+/*
+  Mark phases in the engine.  These cost nothing unless the game is built with
+  PERF=yes, and then only a check of pf_thread unless counters are open.
+ */
+#if WITH_PERF
+#define PF_BEGIN(p) do { if (pf_thread) pf_begin(pf_thread, (p)); } while (0)
+#define PF_END(p) do { if (pf_thread) pf_end(pf_thread, (p)); } while (0)
+#define PF_COUNT(p) do { if (pf_thread) pf_thread->calls[(p)]++; } while (0)
+#else
+#define PF_BEGIN(p) ((void)0)
+#define PF_END(p) ((void)0)
+#define PF_COUNT(p) ((void)0)
+#endif
+
+#endif // PERF_H
@@ -0,0 +1,618 @@
+/***************************************************************************//**
+
+  @file         reference.c
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Frozen reference copy of the tetris game logic.
+
+  This is tetris.c as it stood when the differential tester was written, with
+  everything renamed so that it can be linked next to the real thing.  Don't
+  change it to match tetris.c: difftest checks that tetris.c still plays
+  exactly like this.  Only change it (together with tetris.c) when the rules of
+  the game are meant to change.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "reference.h"
+
+#define MAX(X,Y) ((X) > (Y) ? (X) : (Y))
+#define MIN(X,Y) ((X) < (Y) ? (X) : (Y))
+
+/*******************************************************************************
+
+                               Array Definitions
+
+*******************************************************************************/
+
+static const tetris_location
+REF_TETROMINOS[NUM_TETROMINOS][NUM_ORIENTATIONS][TETRIS] = {
+  // I
+  {{{1, 0}, {1, 1}, {1, 2}, {1, 3}},
+   {{0, 2}, {1, 2}, {2, 2}, {3, 2}},
+   {{3, 0}, {3, 1}, {3, 2}, {3, 3}},
+   {{0, 1}, {1, 1}, {2, 1}, {3, 1}}},
+  // J
+  {{{0, 0}, {1, 0}, {1, 1}, {1, 2}},
+   {{0, 1}, {0, 2}, {1, 1}, {2, 1}},
+   {{1, 0}, {1, 1}, {1, 2}, {2, 2}},
+   {{0, 1}, {1, 1}, {2, 0}, {2, 1}}},
+  // L
+  {{{0, 2}, {1, 0}, {1, 1}, {1, 2}},
+   {{0, 1}, {1, 1}, {2, 1}, {2, 2}},
+   {{1, 0}, {1, 1}, {1, 2}, {2, 0}},
+   {{0, 0}, {0, 1}, {1, 1}, {2, 1}}},
+  // O
+  {{{0, 1}, {0, 2}, {1, 1}, {1, 2}},
+   {{0, 1}, {0, 2}, {1, 1}, {1, 2}},
+   {{0, 1}, {0, 2}, {1, 1}, {1, 2}},
+   {{0, 1}, {0, 2}, {1, 1}, {1, 2}}},
+  // S
+  {{{0, 1}, {0, 2}, {1, 0}, {1, 1}},
+   {{0, 1}, {1, 1}, {1, 2}, {2, 2}},
+   {{1, 1}, {1, 2}, {2, 0}, {2, 1}},
+   {{0, 0}, {1, 0}, {1, 1}, {2, 1}}},
+  // T
+  {{{0, 1}, {1, 0}, {1, 1}, {1, 2}},
+   {{0, 1}, {1, 1}, {1, 2}, {2, 1}},
+   {{1, 0}, {1, 1}, {1, 2}, {2, 1}},
+   {{0, 1}, {1, 0}, {1, 1}, {2, 1}}},
+  // Z
+  {{{0, 0}, {0, 1}, {1, 1}, {1, 2}},
+   {{0, 2}, {1, 1}, {1, 2}, {2, 1}},
+   {{1, 0}, {1, 1}, {2, 1}, {2, 2}},
+   {{0, 1}, {1, 0}, {1, 1}, {2, 0}}},
+};
+
+/*
+  Levels 0-19 fall one cell every 50, 48, ... 8, 4 ticks (rounded up, so the
+  block never falls slower than that).  After that it speeds up to 20G.
+ */
+#define G(cells, ticks) (((cells) * REF_GRAVITY_UNIT + (ticks) - 1) / (ticks))
+static const int REF_GRAVITY_LEVEL[REF_MAX_LEVEL+1] = {
+  // 0-9
+  G(1, 50), G(1, 48), G(1, 46), G(1, 44), G(1, 42),
+  G(1, 40), G(1, 38), G(1, 36), G(1, 34), G(1, 32),
+  // 10-19
+  G(1, 30), G(1, 28), G(1, 26), G(1, 24), G(1, 22),
+  G(1, 20), G(1, 16), G(1, 12), G(1, 8),  G(1, 4),
+  // 20-29
+  G(1, 3),  G(1, 2),  G(1, 1),  G(2, 1),  G(3, 1),
+  G(4, 1),  G(5, 1),  G(10, 1), G(15, 1), G(20, 1)
+};
+#undef G
+
+/*
+  One thing to try when rotating: turn the block by some number of quarter turns
+  clockwise, and move it by an offset.
+ */
+typedef struct {
+  int turns;
+  tetris_location offset;
+} tetris_kick;
+
+/*
+  Everything to try for one rotation, in order.  The first that fits wins.
+ */
+#define MAX_KICKS 10
+typedef struct {
+  int count;
+  tetris_kick kicks[MAX_KICKS];
+} tetris_kick_list;
+
+/*
+  Kick tables are indexed by the orientation rotated from, and then by the
+  direction (0 is clockwise, 1 is counter clockwise).
+
+  The classic system tries the next orientation in place, then one column left,
+  then one column right; failing that, it does the same for the orientation
+  after that, and so on.  It doesn't care about the type or orientation.  The
+  last entry is always "don't rotate", which always fits.
+ */
+static const tetris_kick_list CLASSIC_KICKS[2] = {
+  {10, {{1, {0, 0}}, {1, {0, -1}}, {1, {0, 1}},
+        {2, {0, 0}}, {2, {0, -1}}, {2, {0, 1}},
+        {3, {0, 0}}, {3, {0, -1}}, {3, {0, 1}},
+        {0, {0, 0}}}},
+  {10, {{3, {0, 0}}, {3, {0, -1}}, {3, {0, 1}},
+        {2, {0, 0}}, {2, {0, -1}}, {2, {0, 1}},
+        {1, {0, 0}}, {1, {0, -1}}, {1, {0, 1}},
+        {0, {0, 0}}}},
+};
+
+/*
+  SRS kicks for J, L, S, T and Z.
+ */
+static const tetris_kick_list SRS_KICKS[NUM_ORIENTATIONS][2] = {
+  // 0->R, 0->L
+  {{5, {{1, {0, 0}}, {1, {0, -1}}, {1, {-1, -1}}, {1, {2, 0}}, {1, {2, -1}}}},
+   {5, {{3, {0, 0}}, {3, {0, 1}}, {3, {-1, 1}}, {3, {2, 0}}, {3, {2, 1}}}}},
+  // R->2, R->0
+  {{5, {{1, {0, 0}}, {1, {0, 1}}, {1, {1, 1}}, {1, {-2, 0}}, {1, {-2, 1}}}},
+   {5, {{3, {0, 0}}, {3, {0, 1}}, {3, {1, 1}}, {3, {-2, 0}}, {3, {-2, 1}}}}},
+  // 2->L, 2->R
+  {{5, {{1, {0, 0}}, {1, {0, 1}}, {1, {-1, 1}}, {1, {2, 0}}, {1, {2, 1}}}},
+   {5, {{3, {0, 0}}, {3, {0, -1}}, {3, {-1, -1}}, {3, {2, 0}}, {3, {2, -1}}}}},
+  // L->0, L->2
+  {{5, {{1, {0, 0}}, {1, {0, -1}}, {1, {1, -1}}, {1, {-2, 0}}, {1, {-2, -1}}}},
+   {5, {{3, {0, 0}}, {3, {0, -1}}, {3, {1, -1}}, {3, {-2, 0}}, {3, {-2, -1}}}}},
+};
+
+/*
+  SRS kicks for I.  Our I sits one row lower in orientation 2 than it does in
+  SRS, so rotations into 2 have an extra row up, and rotations out of 2 an extra
+  row down.
+ */
+static const tetris_kick_list SRS_I_KICKS[NUM_ORIENTATIONS][2] = {
+  // 0->R, 0->L
+  {{5, {{1, {0, 0}}, {1, {0, -2}}, {1, {0, 1}}, {1, {1, -2}}, {1, {-2, 1}}}},
+   {5, {{3, {0, 0}}, {3, {0, -1}}, {3, {0, 2}}, {3, {-2, -1}}, {3, {1, 2}}}}},
+  // R->2, R->0
+  {{5, {{1, {-1, 0}}, {1, {-1, -1}}, {1, {-1, 2}}, {1, {-3, -1}}, {1, {0, 2}}}},
+   {5, {{3, {0, 0}}, {3, {0, 2}}, {3, {0, -1}}, {3, {-1, 2}}, {3, {2, -1}}}}},
+  // 2->L, 2->R
+  {{5, {{1, {1, 0}}, {1, {1, 2}}, {1, {1, -1}}, {1, {0, 2}}, {1, {3, -1}}}},
+   {5, {{3, {1, 0}}, {3, {1, 1}}, {3, {1, -2}}, {3, {3, 1}}, {3, {0, -2}}}}},
+  // L->0, L->2
+  {{5, {{1, {0, 0}}, {1, {0, 1}}, {1, {0, -2}}, {1, {2, 1}}, {1, {-1, -2}}}},
+   {5, {{3, {-1, 0}}, {3, {-1, -2}}, {3, {-1, 1}}, {3, {0, -2}}, {3, {-3, 1}}}}},
+};
+
+/*
+  SRS doesn't kick O at all.
+ */
+static const tetris_kick_list SRS_O_KICKS[2] = {
+  {1, {{1, {0, 0}}}},
+  {1, {{3, {0, 0}}}},
+};
+
+/*******************************************************************************
+
+                          Helper Functions for Blocks
+
+*******************************************************************************/
+
+/*
+   Return the block at the given row and column.
+ */
+char ref_get(ref_game *obj, int row, int column)
+{
+  return obj->board[obj->cols * row + column];
+}
+
+/*
+  Set the block at the given row and column.
+ */
+static void ref_set(ref_game *obj, int row, int column, char value)
+{
+  obj->board[obj->cols * row + column] = value;
+}
+
+/*
+  Check whether a row and column are in bounds.
+ */
+static bool ref_check(ref_game *obj, int row, int col)
+{
+  return 0 <= row && row < obj->rows && 0 <= col && col < obj->cols;
+}
+
+/*
+  Place a block onto the board.
+ */
+static void ref_put(ref_game *obj, tetris_block block)
+{
+  int i;
+  for (i = 0; i < TETRIS; i++) {
+    tetris_location cell = REF_TETROMINOS[block.typ][block.ori][i];
+    ref_set(obj, block.loc.row + cell.row, block.loc.col + cell.col,
+           TYPE_TO_CELL(block.typ));
+  }
+}
+
+/*
+  Clear a block out of the board.
+ */
+static void ref_remove(ref_game *obj, tetris_block block)
+{
+  int i;
+  for (i = 0; i < TETRIS; i++) {
+    tetris_location cell = REF_TETROMINOS[block.typ][block.ori][i];
+    ref_set(obj, block.loc.row + cell.row, block.loc.col + cell.col, TC_EMPTY);
+  }
+}
+
+/*
+  Check if a block can be placed on the board.
+ */
+static bool ref_fits(ref_game *obj, tetris_block block)
+{
+  int i, r, c;
+  for (i = 0; i < TETRIS; i++) {
+    tetris_location cell = REF_TETROMINOS[block.typ][block.ori][i];
+    r = block.loc.row + cell.row;
+    c = block.loc.col + cell.col;
+    if (!ref_check(obj, r, c) || TC_IS_FILLED(ref_get(obj, r, c))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+  Return a random tetromino type, advancing the game's xorshift generator.
+ */
+static int ref_random_tetromino(ref_game *obj) {
+  uint32_t x = obj->rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  obj->rng = x;
+  return x % NUM_TETROMINOS;
+}
+
+/*
+  Create a new falling block and populate the next falling block with a random
+  one.
+ */
+static void ref_new_falling(ref_game *obj)
+{
+  // Put in a new falling tetromino.
+  obj->falling = obj->next;
+  obj->next.typ = ref_random_tetromino(obj);
+  obj->next.ori = 0;
+  obj->next.loc.row = 0;
+  obj->next.loc.col = obj->cols/2 - 2;
+}
+
+/*******************************************************************************
+
+                               Game Turn Helpers
+
+*******************************************************************************/
+
+/*
+  Return how many rows the falling block could move down.  The block must be
+  removed from the board first.
+ */
+static int ref_drop_distance(ref_game *obj)
+{
+  int i, r, c, d, distance = obj->rows;
+  for (i = 0; i < TETRIS; i++) {
+    tetris_location cell =
+      REF_TETROMINOS[obj->falling.typ][obj->falling.ori][i];
+    r = obj->falling.loc.row + cell.row;
+    c = obj->falling.loc.col + cell.col;
+    for (d = 0; d < distance; d++) {
+      if (!ref_check(obj, r + d + 1, c) ||
+          TC_IS_FILLED(ref_get(obj, r + d + 1, c)))
+        break;
+    }
+    distance = d;
+  }
+  return distance;
+}
+
+/*
+  Tick gravity, and move the block down if gravity should act.  When gravity
+  adds up to several rows in one tick, the block falls as far as it can, up to
+  that many.  A block that is already resting on something locks instead, and
+  the next one falls a row on the very next tick (as it always has), so gravity
+  is topped up to a whole row by then.
+ */
+static void ref_do_gravity_tick(ref_game *obj)
+{
+  int rows, distance;
+
+  obj->gravity_acc += REF_GRAVITY_LEVEL[obj->level];
+  if (obj->gravity_acc < REF_GRAVITY_UNIT) {
+    return;
+  }
+  rows = obj->gravity_acc / REF_GRAVITY_UNIT;
+  obj->gravity_acc %= REF_GRAVITY_UNIT;
+
+  ref_remove(obj, obj->falling);
+  distance = ref_drop_distance(obj);
+  if (distance > 0) {
+    obj->falling.loc.row += MIN(rows, distance);
+  } else {
+    ref_put(obj, obj->falling);
+    ref_new_falling(obj);
+    obj->gravity_acc = MAX(obj->gravity_acc,
+                           REF_GRAVITY_UNIT - REF_GRAVITY_LEVEL[obj->level]);
+    obj->events |= TE_LOCK;
+  }
+  ref_put(obj, obj->falling);
+}
+
+/*
+  Move the falling tetris block left (-1) or right (+1).
+ */
+static void ref_move(ref_game *obj, int direction)
+{
+  ref_remove(obj, obj->falling);
+  obj->falling.loc.col += direction;
+  if (!ref_fits(obj, obj->falling)) {
+    obj->falling.loc.col -= direction;
+  }
+  ref_put(obj, obj->falling);
+}
+
+/*
+  Send the falling tetris block to the bottom.
+ */
+static void ref_down(ref_game *obj)
+{
+  ref_remove(obj, obj->falling);
+  obj->falling.loc.row += ref_drop_distance(obj);
+  ref_put(obj, obj->falling);
+  ref_new_falling(obj);
+  obj->events |= TE_LOCK;
+}
+
+/*
+  Return the kicks to try when rotating the falling block in either direction
+  (+/-1), under the game's rotation system.
+ */
+static const tetris_kick_list *ref_kicks(ref_game *obj, int direction)
+{
+  int dir = direction < 0;
+  if (obj->rotation == TR_CLASSIC) {
+    return &CLASSIC_KICKS[dir];
+  } else if (obj->falling.typ == TET_I) {
+    return &SRS_I_KICKS[obj->falling.ori][dir];
+  } else if (obj->falling.typ == TET_O) {
+    return &SRS_O_KICKS[dir];
+  } else {
+    return &SRS_KICKS[obj->falling.ori][dir];
+  }
+}
+
+/*
+  Rotate the falling block in either direction (+/-1).  Tries each kick in turn,
+  and leaves the block alone if none of them fit.
+ */
+static void ref_rotate(ref_game *obj, int direction)
+{
+  const tetris_kick_list *list = ref_kicks(obj, direction);
+  tetris_block orig = obj->falling;
+  int i;
+
+  ref_remove(obj, obj->falling);
+
+  for (i = 0; i < list->count; i++) {
+    const tetris_kick *kick = &list->kicks[i];
+    obj->falling.ori = (orig.ori + kick->turns) % NUM_ORIENTATIONS;
+    obj->falling.loc.row = orig.loc.row + kick->offset.row;
+    obj->falling.loc.col = orig.loc.col + kick->offset.col;
+    if (ref_fits(obj, obj->falling))
+      break;
+  }
+  if (i == list->count) {
+    obj->falling = orig;
+  }
+
+  ref_put(obj, obj->falling);
+}
+
+/*
+  Swap the falling block with the block in the hold buffer.  If the held block
+  doesn't fit anywhere above the falling one, nothing happens.
+ */
+static void ref_hold(ref_game *obj)
+{
+  ref_remove(obj, obj->falling);
+  if (obj->stored.typ == -1) {
+    obj->stored = obj->falling;
+    ref_new_falling(obj);
+  } else {
+    tetris_block orig = obj->falling;
+    obj->falling.typ = obj->stored.typ;
+    obj->falling.ori = obj->stored.ori;
+    obj->stored.typ = orig.typ;
+    obj->stored.ori = orig.ori;
+    while (!ref_fits(obj, obj->falling)) {
+      obj->falling.loc.row--;
+      // Blocks can't stick out of the top, so this is as high as we can go.
+      if (obj->falling.loc.row < -TETRIS) {
+        obj->stored.typ = obj->falling.typ;
+        obj->stored.ori = obj->falling.ori;
+        obj->falling = orig;
+        break;
+      }
+    }
+  }
+  ref_put(obj, obj->falling);
+}
+
+/*
+  Perform the action specified by the move.
+ */
+static void ref_handle_move(ref_game *obj, tetris_move move)
+{
+  switch (move) {
+  case TM_LEFT:
+    ref_move(obj, -1);
+    break;
+  case TM_RIGHT:
+    ref_move(obj, 1);
+    break;
+  case TM_DROP:
+    ref_down(obj);
+    break;
+  case TM_CLOCK:
+    ref_rotate(obj, 1);
+    break;
+  case TM_COUNTER:
+    ref_rotate(obj, -1);
+    break;
+  case TM_HOLD:
+    ref_hold(obj);
+    break;
+  default:
+    // pass
+    break;
+  }
+}
+
+/*
+  Return true if line i is full.
+ */
+static bool ref_line_full(ref_game *obj, int i)
+{
+  int j;
+  for (j = 0; j < obj->cols; j++) {
+    if (TC_IS_EMPTY(ref_get(obj, i, j)))
+      return false;
+  }
+  return true;
+}
+
+/*
+  Shift every row above r down one.
+ */
+static void ref_shift_lines(ref_game *obj, int r)
+{
+  int i, j;
+  for (i = r-1; i >= 0; i--) {
+    for (j = 0; j < obj->cols; j++) {
+      ref_set(obj, i+1, j, ref_get(obj, i, j));
+      ref_set(obj, i, j, TC_EMPTY);
+    }
+  }
+}
+
+/*
+  Find rows that are filled, remove them, shift, and return the number of
+  cleared rows.
+ */
+static int ref_check_lines(ref_game *obj)
+{
+  int i, nlines = 0;
+  ref_remove(obj, obj->falling); // don't want to mess up falling block
+
+  for (i = obj->rows-1; i >= 0; i--) {
+    if (ref_line_full(obj, i)) {
+      ref_shift_lines(obj, i);
+      i++; // do this line over again since they're shifted
+      nlines++;
+    }
+  }
+
+  ref_put(obj, obj->falling); // replace
+  return nlines;
+}
+
+/*
+  Adjust the score for the game, given how many lines were just cleared.
+ */
+static void ref_adjust_score(ref_game *obj, int lines_cleared)
+{
+  static int line_multiplier[] = {0, 40, 100, 300, 1200};
+  obj->points += line_multiplier[lines_cleared] * (obj->level + 1);
+  if (lines_cleared > 0) {
+    obj->events |= TE_CLEAR;
+  }
+  if (lines_cleared >= obj->lines_remaining) {
+    if (obj->level < REF_MAX_LEVEL) {
+      obj->events |= TE_LEVEL;
+    }
+    obj->level = MIN(REF_MAX_LEVEL, obj->level + 1);
+    lines_cleared -= obj->lines_remaining;
+    obj->lines_remaining = REF_LINES_PER_LEVEL - lines_cleared;
+  } else {
+    obj->lines_remaining -= lines_cleared;
+  }
+}
+
+/*
+  Return true if the game is over.
+ */
+static bool ref_game_over(ref_game *obj)
+{
+  int i, j;
+  bool over = false;
+  ref_remove(obj, obj->falling);
+  for (i = 0; i < 2; i++) {
+    for (j = 0; j < obj->cols; j++) {
+      if (TC_IS_FILLED(ref_get(obj, i, j))) {
+        over = true;
+      }
+    }
+  }
+  ref_put(obj, obj->falling);
+  return over;
+}
+
+/*******************************************************************************
+
+                             Main Public Functions
+
+*******************************************************************************/
+
+/*
+  Do a single game tick: process gravity, user input, and score.  Return true if
+  the game is still running, false if it is over.
+ */
+bool ref_tick(ref_game *obj, tetris_move move)
+{
+  int lines_cleared;
+  obj->events = 0;
+
+  // Handle gravity.
+  ref_do_gravity_tick(obj);
+
+  // Handle input.
+  ref_handle_move(obj, move);
+
+  // Check for cleared lines
+  lines_cleared = ref_check_lines(obj);
+  obj->lines_cleared = lines_cleared;
+
+  ref_adjust_score(obj, lines_cleared);
+
+  // Return whether the game will continue (NOT whether it's over)
+  return !ref_game_over(obj);
+}
+
+/*
+  Initialize a game whose sequence of tetrominos is determined by the seed.
+ */
+void ref_init_seed(ref_game *obj, int rows, int cols, uint32_t seed)
+{
+  // Initialization logic
+  obj->rows = rows;
+  obj->cols = cols;
+  obj->board = malloc(rows * cols);
+  memset(obj->board, TC_EMPTY, rows * cols);
+  obj->points = 0;
+  obj->level = 0;
+  obj->gravity_acc = 0;
+  obj->lines_remaining = REF_LINES_PER_LEVEL;
+  obj->events = 0;
+  obj->lines_cleared = 0;
+  obj->rotation = TR_CLASSIC;
+  obj->rng = seed ? seed : 1; // xorshift gets stuck on zero
+  ref_new_falling(obj);
+  ref_new_falling(obj);
+  obj->stored.typ = -1;
+  obj->stored.ori = 0;
+  obj->stored.loc.row = 0;
+  obj->stored.loc.col = 0;
+  obj->next.loc.col = obj->cols/2 - 2;
+}
+
+void ref_destroy(ref_game *obj)
+{
+  // Cleanup logic
+  free(obj->board);
+}
@@ -0,0 +1,57 @@
+/***************************************************************************//**
+
+  @file         reference.h
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Frozen reference copy of the tetris game logic.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#ifndef REFERENCE_H
+#define REFERENCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "tetris.h" // for the cell, block and move types
+
+/*
+  The reference's own copy of the rules, so changing them in tetris.h doesn't
+  quietly change the reference too.
+ */
+#define REF_MAX_LEVEL 29
+#define REF_LINES_PER_LEVEL 10
+#define REF_GRAVITY_UNIT 65536
+
+/*
+  The game object, as tetris_game was.
+ */
+typedef struct {
+  int rows;
+  int cols;
+  char *board;
+  int points;
+  int level;
+  tetris_block falling;
+  tetris_block next;
+  tetris_block stored;
+  int gravity_acc;
+  int lines_remaining;
+  uint32_t rng;
+  int events;
+  int lines_cleared;
+  int rotation;
+} ref_game;
+
+void ref_init_seed(ref_game *obj, int rows, int cols, uint32_t seed);
+void ref_destroy(ref_game *obj);
+char ref_get(ref_game *obj, int row, int col);
+bool ref_tick(ref_game *obj, tetris_move move);
+
+#endif // REFERENCE_H
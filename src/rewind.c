@@ -0,0 +1,194 @@
+/***************************************************************************//**
+
+  @file         rewind.c
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Rewinding a game, tick by tick.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rewind.h"
+
+/*
+  An entry in the ring.  It is followed by `nrows` row numbers, and then the
+  old contents of each of those rows.
+ */
+typedef struct {
+  tetris_game header;
+  int nrows;
+  size_t size;
+} rw_entry;
+
+/*
+  Keep entries aligned for rw_entry.
+ */
+#define RW_ALIGN(x) (((x) + sizeof(void*) - 1) & ~(sizeof(void*) - 1))
+
+/*
+  Room for this many changed rows per tick, on average.  Ticks that change more
+  (line clears, mostly) push out older entries sooner.
+ */
+#define RW_ROWS_PER_TICK 4
+
+#define SHADOW(rw, r) ((rw)->shadow + (r) * (rw)->cols)
+
+static size_t rw_entry_size(tetris_rewind *rw, int nrows)
+{
+  return RW_ALIGN(sizeof(rw_entry) + nrows * (sizeof(int) + rw->cols));
+}
+
+static rw_entry *rw_slot(tetris_rewind *rw, int i)
+{
+  return (rw_entry *)(rw->data + rw->slots[(rw->first + i) % rw->nslots]);
+}
+
+/*
+  Set up a rewind buffer that remembers up to `ticks` ticks of the game, starting
+  from its current state.
+ */
+void rw_init(tetris_rewind *rw, tetris_game *obj, int ticks)
+{
+  int i, j;
+
+  rw->rows = obj->rows;
+  rw->cols = obj->cols;
+  rw->shadow = malloc(obj->rows * obj->cols);
+  for (i = 0; i < obj->rows; i++) {
+    for (j = 0; j < obj->cols; j++) {
+      SHADOW(rw, i)[j] = tg_get(obj, i, j);
+    }
+  }
+  rw->last = *obj;
+
+  rw->nslots = ticks;
+  rw->slots = malloc(ticks * sizeof(size_t));
+  rw->first = 0;
+  rw->count = 0;
+  // Always leave room for one tick that changes every row.
+  rw->size = ticks * rw_entry_size(rw, RW_ROWS_PER_TICK) +
+    rw_entry_size(rw, obj->rows);
+  rw->data = malloc(rw->size);
+}
+
+void rw_destroy(tetris_rewind *rw)
+{
+  free(rw->shadow);
+  free(rw->slots);
+  free(rw->data);
+}
+
+/*
+  Remember how to undo the tick that was just played.  Call this after every
+  tick.
+ */
+void rw_record(tetris_rewind *rw, tetris_game *obj)
+{
+  int i, j, nrows = 0;
+  int changed[rw->rows];
+  size_t offset, size, oldest, newest;
+  rw_entry *entry;
+  int *rows;
+  char *cells;
+
+  for (i = 0; i < rw->rows; i++) {
+    for (j = 0; j < rw->cols; j++) {
+      if (SHADOW(rw, i)[j] != tg_get(obj, i, j)) {
+        changed[nrows++] = i;
+        break;
+      }
+    }
+  }
+  size = rw_entry_size(rw, nrows);
+
+  // The entry goes right after the newest one.  Until the ring has wrapped,
+  // there is room up to the end of `data`, and failing that, at the start up to
+  // the oldest entry.  Once it has wrapped, there is only room up to the oldest
+  // entry.  Drop the oldest entries (and free a slot) until it fits somewhere.
+  if (rw->count == rw->nslots) {
+    rw->first = (rw->first + 1) % rw->nslots;
+    rw->count--;
+  }
+  while (true) {
+    if (rw->count == 0) {
+      offset = 0;
+      break;
+    }
+    oldest = rw->slots[rw->first];
+    newest = rw->slots[(rw->first + rw->count - 1) % rw->nslots];
+    offset = newest + rw_slot(rw, rw->count - 1)->size;
+    if (newest >= oldest && offset + size <= rw->size) {
+      break;
+    }
+    if (newest >= oldest && size <= oldest) {
+      offset = 0;
+      break;
+    }
+    if (newest < oldest && offset + size <= oldest) {
+      break;
+    }
+    rw->first = (rw->first + 1) % rw->nslots;
+    rw->count--;
+  }
+
+  rw->slots[(rw->first + rw->count) % rw->nslots] = offset;
+  rw->count++;
+  entry = (rw_entry *)(rw->data + offset);
+  entry->header = rw->last;
+  entry->nrows = nrows;
+  entry->size = size;
+  rows = (int *)(entry + 1);
+  cells = (char *)(rows + nrows);
+  for (i = 0; i < nrows; i++) {
+    rows[i] = changed[i];
+    memcpy(cells + i * rw->cols, SHADOW(rw, changed[i]), rw->cols);
+    for (j = 0; j < rw->cols; j++) {
+      SHADOW(rw, changed[i])[j] = tg_get(obj, changed[i], j);
+    }
+  }
+  rw->last = *obj;
+}
+
+/*
+  Undo up to `ticks` of the most recent ticks.  Returns how many were undone,
+  which is fewer if the buffer runs out.
+ */
+int rw_rewind(tetris_rewind *rw, tetris_game *obj, int ticks)
+{
+  int n, i, j;
+  rw_entry *entry;
+  int *rows;
+  char *cells;
+  tetris_game storage;
+
+  for (n = 0; n < ticks && rw->count > 0; n++) {
+    entry = rw_slot(rw, --rw->count);
+    rows = (int *)(entry + 1);
+    cells = (char *)(rows + entry->nrows);
+    for (i = 0; i < entry->nrows; i++) {
+      memcpy(SHADOW(rw, rows[i]), cells + i * rw->cols, rw->cols);
+      for (j = 0; j < rw->cols; j++) {
+        tg_set(obj, rows[i], j, cells[i * rw->cols + j]);
+      }
+    }
+    // The board is already restored, and its storage is laid out however it
+    // is now, so only take the rest of the header.
+    storage = *obj;
+    *obj = entry->header;
+    obj->board = storage.board;
+    obj->row_index = storage.row_index;
+    obj->row_head = storage.row_head;
+    obj->row_fill = storage.row_fill;
+    obj->full_rows = storage.full_rows;
+  }
+  rw->last = *obj;
+  return n;
+}
@@ -0,0 +1,56 @@
+/***************************************************************************//**
+
+  @file         rewind.h
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Rewinding a game, tick by tick.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <stddef.h>
+
+#include "tetris.h"
+
+/*
+  A rewind buffer keeps one entry per recorded tick, enough to undo that tick:
+  the game header from before it, and the old contents of the rows it changed.
+  Entries live in a fixed size ring of bytes, and the oldest are dropped to make
+  room, so memory use never grows.  Rewinding n ticks undoes the n newest
+  entries, newest first.
+ */
+typedef struct {
+  /*
+    The board and header as of the last recorded tick, to compare against.
+   */
+  int rows;
+  int cols;
+  char *shadow;
+  tetris_game last;
+  /*
+    Ring of entries.  Each one starts at a slot's offset in `data`.  Entries
+    don't wrap around the end of `data`; if one doesn't fit, it goes at the
+    start, once the entries there have been dropped.
+   */
+  size_t *slots;
+  int nslots;
+  int first;
+  int count;
+  unsigned char *data;
+  size_t size;
+} tetris_rewind;
+
+void rw_init(tetris_rewind *rw, tetris_game *obj, int ticks);
+void rw_destroy(tetris_rewind *rw);
+void rw_record(tetris_rewind *rw, tetris_game *obj);
+int rw_rewind(tetris_rewind *rw, tetris_game *obj, int ticks);
+
+#endif // REWIND_H
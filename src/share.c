@@ -0,0 +1,271 @@
+/***************************************************************************//**
+
+  @file         share.c
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Publishing a running game in shared memory.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>  // kill
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "share.h"
+
+/*
+  Map a shared memory object of the given size.  Returns -1 on error, with errno
+  set.
+ */
+static int sh_map(tetris_share *sh, int fd, size_t size)
+{
+  void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    return -1;
+  }
+  sh->seg = p;
+  sh->size = size;
+  return 0;
+}
+
+/*
+  Return true if a segment that already exists was left by a game that isn't
+  running any more.  Only the pid is looked at, since a game that died while
+  setting up never got as far as the magic number.  No pid yet (or no room for
+  one) means it died before that, and a version 1 segment has none at all; in
+  the unlikely case that its game is really still starting or running, it just
+  keeps its segment without the name.
+ */
+static bool sh_stale(const char *name)
+{
+  struct stat st;
+  sh_segment *seg;
+  bool stale;
+  int fd = shm_open(name, O_RDONLY, 0);
+
+  if (fd < 0) {
+    return errno == ENOENT;
+  }
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return false;
+  }
+  if ((size_t)st.st_size < sizeof(sh_segment)) {
+    close(fd);
+    return true;
+  }
+  seg = mmap(NULL, sizeof(sh_segment), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (seg == MAP_FAILED) {
+    return false;
+  }
+  stale = seg->pid <= 0 || (seg->magic == SH_MAGIC && seg->version == 1) ||
+    (kill(seg->pid, 0) < 0 && errno == ESRCH);
+  munmap(seg, sizeof(sh_segment));
+  return stale;
+}
+
+/*
+  Create a segment named `name` (like "/tetris") for a game, and publish its
+  current state.  A segment left by a game that has exited is replaced, but not
+  one that's still in use.  Returns -1 on error, with errno set (EEXIST if
+  another game has the name).
+ */
+int sh_create(tetris_share *sh, const char *name, tetris_game *obj)
+{
+  size_t size = sizeof(sh_segment) + obj->rows * obj->cols;
+  int fd, i;
+
+  fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+  if (fd < 0 && errno == EEXIST && sh_stale(name)) {
+    shm_unlink(name);
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+  }
+  if (fd < 0 && errno == ENOENT) {
+    errno = EEXIST;
+  }
+  if (fd < 0) {
+    return -1;
+  }
+  if (ftruncate(fd, size) < 0) {
+    close(fd);
+    shm_unlink(name);
+    return -1;
+  }
+  if (sh_map(sh, fd, size) < 0) {
+    shm_unlink(name);
+    return -1;
+  }
+  // First of all, so a game that dies from here on leaves a stale segment.
+  sh->seg->pid = getpid();
+  sh->name = strdup(name);
+  sh->owner = true;
+
+  sh->seg->rows = obj->rows;
+  sh->seg->cols = obj->cols;
+  sh->seg->seq = 0;
+  sh->seg->state.locks = 0;
+  sh->seg->input_head = 0;
+  sh->seg->input_tail = 0;
+  for (i = 0; i < SH_INPUT_SIZE; i++) {
+    sh->seg->input[i] = -1;
+  }
+  sh_publish(sh, obj, 0, true);
+  // Readers check these last, so they don't see a half made segment.
+  sh->seg->version = SH_VERSION;
+  __atomic_store_n(&sh->seg->magic, SH_MAGIC, __ATOMIC_RELEASE);
+  return 0;
+}
+
+/*
+  Publish the game's state.  Call this after every tick.
+ */
+void sh_publish(tetris_share *sh, tetris_game *obj, uint64_t tick,
+                bool running)
+{
+  sh_segment *seg = sh->seg;
+  uint32_t seq = seg->seq;
+  int i;
+
+  __atomic_store_n(&seg->seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  seg->state.tick = tick;
+  seg->state.running = running;
+  seg->state.points = obj->points;
+  seg->state.level = obj->level;
+  seg->state.lines_remaining = obj->lines_remaining;
+  seg->state.rotation = obj->rotation;
+  if (obj->events & TE_LOCK) {
+    seg->state.locks++;
+  }
+  seg->state.falling = obj->falling;
+  seg->state.next = obj->next;
+  seg->state.stored = obj->stored;
+  for (i = 0; i < obj->rows; i++) {
+    memcpy(seg->board + i * obj->cols, tg_row(obj, i), obj->cols);
+  }
+
+  __atomic_store_n(&seg->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/*
+  Take the next move sent through the input ring, or TM_NONE if there isn't
+  one.
+ */
+tetris_move sh_take_move(tetris_share *sh)
+{
+  sh_segment *seg = sh->seg;
+  uint32_t tail = seg->input_tail;
+  int8_t *slot = &seg->input[tail % SH_INPUT_SIZE];
+  int8_t move = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+
+  if (move < 0) {
+    return TM_NONE; // empty, or claimed but not filled in yet
+  }
+  __atomic_store_n(slot, -1, __ATOMIC_RELAXED);
+  __atomic_store_n(&seg->input_tail, tail + 1, __ATOMIC_RELEASE);
+  return move <= TM_NONE ? move : TM_NONE;
+}
+
+/*
+  Open a game's segment, to read it and send it moves.  Returns -1 on error,
+  with errno set.
+ */
+int sh_open(tetris_share *sh, const char *name)
+{
+  struct stat st;
+  int fd = shm_open(name, O_RDWR, 0);
+
+  if (fd < 0) {
+    return -1;
+  }
+  if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(sh_segment)) {
+    close(fd);
+    return -1;
+  }
+  if (sh_map(sh, fd, st.st_size) < 0) {
+    return -1;
+  }
+  if (__atomic_load_n(&sh->seg->magic, __ATOMIC_ACQUIRE) != SH_MAGIC ||
+      sh->seg->version != SH_VERSION ||
+      sizeof(sh_segment) + sh->seg->rows * sh->seg->cols > sh->size) {
+    munmap(sh->seg, sh->size);
+    return -1;
+  }
+  sh->name = strdup(name);
+  sh->owner = false;
+  return 0;
+}
+
+/*
+  Copy a consistent snapshot of the game: its state, and its board if `board`
+  isn't NULL (rows * cols bytes).  Returns the sequence number it was taken at,
+  which changes whenever the game does.
+ */
+uint32_t sh_snapshot(tetris_share *sh, sh_state *state, char *board)
+{
+  sh_segment *seg = sh->seg;
+  uint32_t before, after;
+
+  do {
+    before = __atomic_load_n(&seg->seq, __ATOMIC_ACQUIRE);
+    if (before & 1) {
+      continue;
+    }
+    memcpy(state, &seg->state, sizeof(sh_state));
+    if (board) {
+      memcpy(board, seg->board, seg->rows * seg->cols);
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    after = __atomic_load_n(&seg->seq, __ATOMIC_RELAXED);
+  } while ((before & 1) || before != after);
+  return before;
+}
+
+/*
+  Send a move to the game.  Returns false if the ring is full.
+ */
+bool sh_send_move(tetris_share *sh, tetris_move move)
+{
+  sh_segment *seg = sh->seg;
+  uint32_t head = __atomic_load_n(&seg->input_head, __ATOMIC_RELAXED);
+
+  do {
+    if (head - __atomic_load_n(&seg->input_tail, __ATOMIC_ACQUIRE) >=
+        SH_INPUT_SIZE) {
+      return false;
+    }
+  } while (!__atomic_compare_exchange_n(&seg->input_head, &head, head + 1,
+                                        true, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED));
+  __atomic_store_n(&seg->input[head % SH_INPUT_SIZE], (int8_t)move,
+                   __ATOMIC_RELEASE);
+  return true;
+}
+
+/*
+  Unmap the segment.  The game also removes it.
+ */
+void sh_close(tetris_share *sh)
+{
+  munmap(sh->seg, sh->size);
+  if (sh->owner) {
+    shm_unlink(sh->name);
+  }
+  free(sh->name);
+}
@@ -0,0 +1,98 @@
+/***************************************************************************//**
+
+  @file         share.h
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Publishing a running game in shared memory.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#ifndef SHARE_H
+#define SHARE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "tetris.h"
+
+#define SH_MAGIC 0x48534754 // "TGSH"
+#define SH_VERSION 2
+
+/*
+  Size of the input ring (a power of two).
+ */
+#define SH_INPUT_SIZE 64
+
+/*
+  The state of a game, as published.
+ */
+typedef struct {
+  uint64_t tick;
+  int32_t running;
+  int32_t points;
+  int32_t level;
+  int32_t lines_remaining;
+  uint32_t locks; // blocks locked so far
+  int32_t rotation; // a tetris_rotation
+  tetris_block falling;
+  tetris_block next;
+  tetris_block stored;
+} sh_state;
+
+/*
+  A shared memory segment holding a game.  The game writes it every tick, and
+  any number of other processes can map it and read it.  Only one game at a
+  time can have a name; `pid` lets a new game tell if the last one has exited.
+
+  The state and board are guarded by a sequence lock: `seq` is odd while the
+  game is writing.  Readers copy what they need, and retry if `seq` was odd or
+  changed in the meantime.  The game never waits for readers.
+
+  The input ring lets other processes send moves to the game.  Senders claim a
+  slot by advancing `input_head`, and fill it in; the game takes one move per
+  tick from `input_tail`.  Empty slots hold -1.
+ */
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  int32_t pid; // of the game
+  int32_t rows;
+  int32_t cols;
+  uint32_t seq;
+  sh_state state;
+  uint32_t input_head;
+  uint32_t input_tail;
+  int8_t input[SH_INPUT_SIZE];
+  char board[]; // rows * cols cells, row by row
+} sh_segment;
+
+/*
+  A process's view of a segment.
+ */
+typedef struct {
+  char *name;
+  bool owner;
+  size_t size;
+  sh_segment *seg;
+} tetris_share;
+
+// The game's side.
+int sh_create(tetris_share *sh, const char *name, tetris_game *obj);
+void sh_publish(tetris_share *sh, tetris_game *obj, uint64_t tick,
+                bool running);
+tetris_move sh_take_move(tetris_share *sh);
+
+// Everyone else's side.
+int sh_open(tetris_share *sh, const char *name);
+uint32_t sh_snapshot(tetris_share *sh, sh_state *state, char *board);
+bool sh_send_move(tetris_share *sh, tetris_move move);
+
+void sh_close(tetris_share *sh);
+
+#endif // SHARE_H
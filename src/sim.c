@@ -0,0 +1,301 @@
+/***************************************************************************//**
+
+  @file         sim.c
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Headless simulator: bots playing many games on many threads.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>  // getopt, sysconf
+#include <pthread.h>
+
+#include "tetris.h"
+#include "bot.h"
+#include "archive.h"
+#include "export.h"
+#include "util.h"
+#include "perf.h"
+
+/*
+  Settings and shared state for a simulation run.
+ */
+typedef struct {
+  int games;
+  int threads;
+  int rows;
+  int cols;
+  uint32_t seed;
+  uint32_t max_ticks;
+  int rotation;
+  tetris_archive *archive;
+  tetris_export *export;
+  bool perf;
+
+  pthread_mutex_t lock;
+  int next_game;
+  int played;
+  long long ticks;
+  long long points;
+  tetris_perf counters; // every thread's, added up
+  int perf_threads;     // threads that had counters
+} simulation;
+
+/*
+  Play one game with a bot until it's over or runs out of ticks.  If given a
+  writer, export a record for each placement.
+ */
+static void play(simulation *sim, int number, tetris_export_writer *w)
+{
+  uint32_t ticks = 0, seed = sim->seed + number;
+  tetris_game game;
+  tetris_bot bot;
+  tetris_block falling;
+  bool running = true, placing = false;
+  int points;
+
+  tg_init_seed(&game, sim->rows, sim->cols, seed);
+  game.rotation = sim->rotation;
+  bot_init(&bot, &game);
+  while (running && ticks < sim->max_ticks) {
+    if (w && !placing) {
+      tx_begin(w, &game);
+      placing = true;
+    }
+    falling = game.falling;
+    points = game.points;
+
+    running = tg_tick(&game, bot_move(&bot, &game));
+    ticks++;
+
+    if (w && (game.events & TE_LOCK)) {
+      tx_end(w, falling, game.lines_cleared, game.points - points);
+      placing = false;
+    }
+  }
+
+  if (sim->archive && ta_append(sim->archive, &game, seed, ticks) < 0) {
+    perror("sim: archive");
+  }
+
+  pthread_mutex_lock(&sim->lock);
+  sim->played++;
+  sim->ticks += ticks;
+  sim->points += game.points;
+  pthread_mutex_unlock(&sim->lock);
+
+  bot_destroy(&bot);
+  tg_destroy(&game);
+}
+
+/*
+  Thread body: keep taking games until there are none left.
+ */
+static void *worker(void *arg)
+{
+  simulation *sim = arg;
+  tetris_export_writer w;
+  tetris_perf counters;
+  int number;
+
+  if (sim->export) {
+    tx_writer_init(&w, sim->export, 0);
+  }
+  // Counters only count the thread that opens them, so each thread has its own.
+  if (sim->perf && pf_open(&counters) < 0) {
+    perror("sim: perf_event_open");
+  }
+  while (true) {
+    pthread_mutex_lock(&sim->lock);
+    number = sim->next_game++;
+    pthread_mutex_unlock(&sim->lock);
+    // Once the export can't be written, there's no point in playing on.
+    if (number >= sim->games || (sim->export && tx_error(sim->export))) {
+      break;
+    }
+    play(sim, number, sim->export ? &w : NULL);
+  }
+  if (sim->export) {
+    tx_writer_destroy(&w);
+  }
+  if (sim->perf && pf_thread) {
+    pf_close(&counters);
+    pthread_mutex_lock(&sim->lock);
+    pf_add(&sim->counters, &counters);
+    sim->perf_threads++;
+    pthread_mutex_unlock(&sim->lock);
+  }
+  return NULL;
+}
+
+/*
+  Return seconds since some fixed point.
+ */
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+  Print a summary of every game in an archive, reading records in place.
+ */
+static int list(const char *path)
+{
+  tetris_archive_map map;
+  const tetris_record *rec;
+  long long games = 0, points = 0, ticks = 0;
+  const tetris_record *best = NULL;
+
+  if (ta_map(&map, path) < 0) {
+    fprintf(stderr, "sim: unable to read archive \"%s\"\n", path);
+    return EXIT_FAILURE;
+  }
+  for (rec = ta_next(&map, NULL); rec != NULL; rec = ta_next(&map, rec)) {
+    games++;
+    points += rec->points;
+    ticks += rec->ticks;
+    if (best == NULL || rec->points > best->points) {
+      best = rec;
+    }
+  }
+  printf("%lld games, %lld ticks, %.1f points on average.\n", games, ticks,
+         games ? (double)points / games : 0.0);
+  if (best) {
+    printf("Best: game %u (seed %u), %d points on level %d.\n", best->id,
+           best->seed, best->points, best->level);
+  }
+  ta_unmap(&map);
+  return EXIT_SUCCESS;
+}
+
+static void usage(void)
+{
+  fprintf(stderr,
+          "usage: sim [-n games] [-j threads] [-s seed] [-m max_ticks]\n"
+          "           [-r rows] [-c cols] [-k classic|srs] [-o archive]\n"
+          "           [-x export] [-p]\n"
+          "       sim -l archive\n");
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+  simulation sim;
+  pthread_t *threads;
+  double start, elapsed;
+  char *archive = NULL, *export = NULL;
+  int i, opt, error = 0;
+
+  sim.games = 100;
+  sim.threads = sysconf(_SC_NPROCESSORS_ONLN);
+  sim.rows = 22;
+  sim.cols = 10;
+  sim.seed = time(NULL);
+  sim.max_ticks = 1000000;
+  sim.rotation = TR_CLASSIC;
+  sim.archive = NULL;
+  sim.export = NULL;
+  sim.perf = false;
+
+  while ((opt = getopt(argc, argv, "n:j:s:m:r:c:k:o:x:l:p")) != -1) {
+    switch (opt) {
+    case 'n': sim.games = atoi(optarg); break;
+    case 'j': sim.threads = atoi(optarg); break;
+    case 's': sim.seed = strtoul(optarg, NULL, 0); break;
+    case 'm': sim.max_ticks = strtoul(optarg, NULL, 0); break;
+    case 'r': sim.rows = atoi(optarg); break;
+    case 'c': sim.cols = atoi(optarg); break;
+    case 'k': sim.rotation = parse_rotation(optarg); break;
+    case 'o': archive = optarg; break;
+    case 'x': export = optarg; break;
+    case 'l': return list(optarg);
+    case 'p': sim.perf = true; break;
+    default: usage();
+    }
+  }
+  if (sim.games < 0 || sim.threads < 1 || sim.rows < 4 || sim.cols < 4 ||
+      sim.rotation < 0) {
+    usage();
+  }
+#if !WITH_PERF
+  if (sim.perf) {
+    fprintf(stderr, "sim: -p needs a build with PERF=yes\n");
+    exit(EXIT_FAILURE);
+  }
+#endif
+
+  if (archive) {
+    sim.archive = ta_open(archive);
+    if (sim.archive == NULL) {
+      perror("sim");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (export) {
+    sim.export = tx_open(export, sim.rows, sim.cols);
+    if (sim.export == NULL) {
+      perror("sim");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  pthread_mutex_init(&sim.lock, NULL);
+  sim.next_game = 0;
+  sim.played = 0;
+  sim.ticks = 0;
+  sim.points = 0;
+  pf_clear(&sim.counters);
+  sim.perf_threads = 0;
+
+  start = now();
+  threads = malloc(sim.threads * sizeof(pthread_t));
+  for (i = 0; i < sim.threads; i++) {
+    pthread_create(&threads[i], NULL, worker, &sim);
+  }
+  for (i = 0; i < sim.threads; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  elapsed = now() - start;
+  free(threads);
+
+  printf("%d games, %lld ticks in %.3f s (%.0f ticks/s) on %d threads.\n",
+         sim.played, sim.ticks, elapsed, sim.ticks / elapsed, sim.threads);
+  printf("%.1f points on average.\n",
+         sim.played ? (double)sim.points / sim.played : 0.0);
+
+  if (sim.perf_threads > 0) {
+    pf_report(&sim.counters, stdout);
+  }
+
+  if (sim.export) {
+    printf("Exported %llu placements (%llu bytes).\n",
+           (unsigned long long)sim.export->records,
+           (unsigned long long)sim.export->end);
+    if ((error = tx_error(sim.export)) != 0) {
+      fprintf(stderr, "sim: export: %s; stopped after %d games\n",
+              strerror(error), sim.played);
+    }
+    tx_close(sim.export);
+  }
+  if (sim.archive) {
+    ta_close(sim.archive);
+  }
+  pthread_mutex_destroy(&sim.lock);
+  return error ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,178 @@
+/***************************************************************************//**
+
+  @file         solve.c
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Command line perfect clear and puzzle solver.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>  // getopt, sysconf
+
+#include "tetris.h"
+#include "solver.h"
+#include "util.h"
+
+static void usage(void)
+{
+  fprintf(stderr,
+          "usage: solve [-q pieces] [-i hold] [-d lines] [-e] [-j threads]\n"
+          "             [-r rows] [-c cols] [layout_file | -g save_file]\n");
+  exit(EXIT_FAILURE);
+}
+
+/*
+  Read a board layout: one line per row, with '.' or ' ' for an empty cell and
+  anything else for a filled one.  The rows go at the bottom of the board.
+  Returns false if it doesn't fit.
+ */
+static bool read_layout(tetris_solver *sv, FILE *f)
+{
+  char lines[SV_MAX_ROWS][SV_MAX_COLS + 2], *line;
+  int n = 0, i, j, len;
+
+  while (n < SV_MAX_ROWS && fgets(lines[n], sizeof(lines[n]), f)) {
+    lines[n][strcspn(lines[n], "\r\n")] = '\0';
+    n++;
+  }
+  if (!feof(f) || n > sv->rows) {
+    return false;
+  }
+  for (i = 0; i < n; i++) {
+    line = lines[i];
+    len = strlen(line);
+    if (len > sv->cols) {
+      return false;
+    }
+    for (j = 0; j < len; j++) {
+      if (line[j] != '.' && line[j] != ' ') {
+        sv_set(sv, sv->rows - n + i, j);
+      }
+    }
+  }
+  return true;
+}
+
+/*
+  Add pieces named by letters to the queue.  Returns false on a bad name.
+ */
+static bool read_pieces(tetris_solver *sv, const char *names)
+{
+  for (; *names; names++) {
+    if (sv->npieces == SV_MAX_PIECES || sv_parse_piece(*names) < 0) {
+      return false;
+    }
+    sv->queue[sv->npieces++] = sv_parse_piece(*names);
+  }
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  tetris_solver sv;
+  tetris_game *game;
+  FILE *f;
+  char *pieces = NULL, *save = NULL;
+  int opt, i, rows = 22, cols = 10, hold = -1, height = 4;
+  int threads = sysconf(_SC_NPROCESSORS_ONLN);
+  bool exhaustive = false;
+  long start;
+
+  while ((opt = getopt(argc, argv, "q:i:d:ej:r:c:g:")) != -1) {
+    switch (opt) {
+    case 'q': pieces = optarg; break;
+    case 'i':
+      if ((hold = sv_parse_piece(optarg[0])) < 0) {
+        usage();
+      }
+      break;
+    case 'd': height = atoi(optarg); break;
+    case 'e': exhaustive = true; break;
+    case 'j': threads = atoi(optarg); break;
+    case 'r': rows = atoi(optarg); break;
+    case 'c': cols = atoi(optarg); break;
+    case 'g': save = optarg; break;
+    default: usage();
+    }
+  }
+  if (rows < 4 || rows > SV_MAX_ROWS || cols < 4 || cols > SV_MAX_COLS ||
+      height < 0 || height > rows || threads < 1) {
+    usage();
+  }
+
+  // Set up the puzzle: from a saved game, a layout, or an empty board.
+  if (save) {
+    if ((f = fopen(save, "r")) == NULL) {
+      perror("solve");
+      exit(EXIT_FAILURE);
+    }
+    game = tg_load(f);
+    fclose(f);
+    if (game->rows > SV_MAX_ROWS || game->cols > SV_MAX_COLS) {
+      fprintf(stderr, "solve: the saved board is too big\n");
+      exit(EXIT_FAILURE);
+    }
+    sv_from_game(&sv, game);
+    tg_delete(game);
+  } else {
+    sv_init(&sv, rows, cols);
+    if (optind < argc) {
+      f = strcmp(argv[optind], "-") == 0 ? stdin : fopen(argv[optind], "r");
+      if (f == NULL) {
+        perror("solve");
+        exit(EXIT_FAILURE);
+      }
+      if (!read_layout(&sv, f)) {
+        fprintf(stderr, "solve: the layout doesn't fit a %dx%d board\n",
+                rows, cols);
+        exit(EXIT_FAILURE);
+      }
+      if (f != stdin) {
+        fclose(f);
+      }
+    }
+  }
+  if (hold >= 0) {
+    sv.hold = hold;
+  }
+  if (pieces && !read_pieces(&sv, pieces)) {
+    fprintf(stderr, "solve: pieces are I, J, L, O, S, T and Z (at most %d)\n",
+            SV_MAX_PIECES);
+    exit(EXIT_FAILURE);
+  }
+  sv.height = height;
+  sv.threads = threads;
+  sv.exhaustive = exhaustive;
+
+  start = clock_micro();
+  sv_solve(&sv);
+
+  if (sv.perfect) {
+    printf("Perfect clear with %d pieces.\n", sv.nsteps);
+  } else if (sv.nsteps > 0) {
+    printf("No perfect clear; best is %d lines with %d pieces.\n", sv.lines,
+           sv.nsteps);
+  } else {
+    printf("No solution.\n");
+  }
+  for (i = 0; i < sv.nsteps; i++) {
+    printf("%2d. %s%c: orientation %d, row %d, column %d\n", i + 1,
+           sv.steps[i].hold ? "hold, " : "", sv_piece_name(sv.steps[i].typ),
+           sv.steps[i].ori, sv.steps[i].loc.row, sv.steps[i].loc.col);
+  }
+  printf("Searched %lld positions in %.3f ms on %d threads.\n", sv.nodes,
+         (clock_micro() - start) / 1000.0, sv.threads);
+  return sv.perfect ? EXIT_SUCCESS : EXIT_FAILURE;
+}
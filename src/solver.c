@@ -0,0 +1,703 @@
+/***************************************************************************//**
+
+  @file         solver.c
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Perfect clear and puzzle solver.
+
+  The search is a depth first search over placements, split across threads at
+  the first placement.  Board states already searched (by any thread) are kept
+  in a shared hash table and skipped.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "solver.h"
+
+/*
+  Size of the table of searched states (a power of two), and how far to probe
+  for a free slot before giving up on remembering a state.
+ */
+#define SV_MEMO_BITS 22
+#define SV_MEMO_PROBES 16
+
+static const char PIECE_NAMES[NUM_TETROMINOS] = "IJLOSTZ";
+
+/*
+  A piece shape, in one orientation: a row mask for each row it covers, shifted
+  so that its leftmost cell is bit 0.  `top` and `left` are the offsets of its
+  top row and leftmost cell within the TETROMINOS block, and `height` and
+  `width` its size.
+ */
+typedef struct {
+  uint16_t mask[TETRIS];
+  int top, left, height, width;
+  bool duplicate; // same shape as an earlier orientation
+} sv_shape;
+
+static sv_shape SHAPES[NUM_TETROMINOS][NUM_ORIENTATIONS];
+
+/*
+  A node of the search: the board, and which pieces are left.
+ */
+typedef struct {
+  uint16_t board[SV_MAX_ROWS];
+  int next;  // index of the next piece in the queue
+  int hold;
+  int lines; // cleared so far
+} sv_node;
+
+/*
+  Shared search state.
+ */
+typedef struct {
+  tetris_solver *sv;
+  uint16_t full;     // mask of a full row
+  uint64_t *memo;
+  pthread_mutex_t lock;
+  int done;          // set once there's a perfect clear, to stop everyone
+  int best;          // most lines found so far (read without the lock)
+  bool perfect;      // false if a perfect clear is already ruled out
+  /*
+    The first placements, for threads to take one at a time.
+   */
+  sv_node *roots;
+  sv_step *root_steps;
+  int nroots;
+  int next_root;
+} sv_search;
+
+/*
+  One thread's part of the search.
+ */
+typedef struct {
+  sv_search *s;
+  sv_step path[SV_MAX_PIECES];
+  long long nodes;
+} sv_worker;
+
+/*
+  Where a node is in a worker's search, for visiting its children.
+ */
+typedef struct {
+  sv_worker *w;
+  int depth;
+} sv_position;
+
+/*******************************************************************************
+
+                                   Shapes
+
+*******************************************************************************/
+
+static void sv_init_shapes(void)
+{
+  int t, o, p, i, r, c;
+  sv_shape *sh;
+  for (t = 0; t < NUM_TETROMINOS; t++) {
+    for (o = 0; o < NUM_ORIENTATIONS; o++) {
+      sh = &SHAPES[t][o];
+      sh->top = sh->left = TETRIS;
+      sh->height = sh->width = 0;
+      for (i = 0; i < TETRIS; i++) {
+        sh->top = TETROMINOS[t][o][i].row < sh->top ?
+          TETROMINOS[t][o][i].row : sh->top;
+        sh->left = TETROMINOS[t][o][i].col < sh->left ?
+          TETROMINOS[t][o][i].col : sh->left;
+      }
+      memset(sh->mask, 0, sizeof(sh->mask));
+      for (i = 0; i < TETRIS; i++) {
+        r = TETROMINOS[t][o][i].row - sh->top;
+        c = TETROMINOS[t][o][i].col - sh->left;
+        sh->mask[r] |= 1 << c;
+        sh->height = r + 1 > sh->height ? r + 1 : sh->height;
+        sh->width = c + 1 > sh->width ? c + 1 : sh->width;
+      }
+      sh->duplicate = false;
+      for (p = 0; p < o; p++) {
+        if (memcmp(SHAPES[t][p].mask, sh->mask, sizeof(sh->mask)) == 0) {
+          sh->duplicate = true;
+        }
+      }
+    }
+  }
+}
+
+/*******************************************************************************
+
+                               Board Helpers
+
+*******************************************************************************/
+
+static bool sv_fits(sv_search *s, const uint16_t *board, const sv_shape *sh,
+                    int row, int col)
+{
+  int i;
+  if (row + sh->height > s->sv->rows) {
+    return false;
+  }
+  for (i = 0; i < sh->height; i++) {
+    if (board[row + i] & (sh->mask[i] << col)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+  Drop a shape straight down in a column, from the top.  Returns the row its top
+  lands on, or -1 if it doesn't fit at the top.
+ */
+static int sv_drop(sv_search *s, const uint16_t *board, const sv_shape *sh,
+                   int col)
+{
+  int row = 0;
+  if (!sv_fits(s, board, sh, row, col)) {
+    return -1;
+  }
+  while (sv_fits(s, board, sh, row + 1, col)) {
+    row++;
+  }
+  return row;
+}
+
+/*
+  Remove full rows in [first, last], shifting the rows above down.  Returns how
+  many were removed.
+ */
+static int sv_clear(sv_search *s, uint16_t *board, int first, int last)
+{
+  int r, n = 0;
+  for (r = last; r >= first + n; r--) {
+    if (board[r] == s->full) {
+      memmove(board + 1, board, r * sizeof(uint16_t));
+      board[0] = 0;
+      n++;
+      r++; // look at this row again, since it was shifted
+    }
+  }
+  return n;
+}
+
+static int sv_popcount(unsigned x)
+{
+  return __builtin_popcount(x);
+}
+
+/*
+  Return true if every area of empty cells in rows [first, rows) could be
+  filled with whole pieces, i.e. has a multiple of 4 cells.
+ */
+static bool sv_areas_ok(sv_search *s, const uint16_t *board, int first)
+{
+  int rows = s->sv->rows, r, n;
+  uint16_t empty[SV_MAX_ROWS], area[SV_MAX_ROWS], grown;
+  bool changed;
+
+  for (r = first; r < rows; r++) {
+    empty[r] = ~board[r] & s->full;
+  }
+  for (;;) {
+    // Start an area at the first empty cell left.
+    for (r = first; r < rows && !empty[r]; r++);
+    if (r == rows) {
+      return true;
+    }
+    memset(area + first, 0, (rows - first) * sizeof(uint16_t));
+    area[r] = empty[r] & -empty[r];
+    // Grow it until it stops.
+    do {
+      changed = false;
+      for (r = first; r < rows; r++) {
+        grown = area[r] | (area[r] << 1) | (area[r] >> 1);
+        if (r > first) grown |= area[r - 1];
+        if (r < rows - 1) grown |= area[r + 1];
+        grown &= empty[r];
+        if (grown != area[r]) {
+          area[r] = grown;
+          changed = true;
+        }
+      }
+    } while (changed);
+    n = 0;
+    for (r = first; r < rows; r++) {
+      n += sv_popcount(area[r]);
+      empty[r] &= ~area[r];
+    }
+    if (n % 4 != 0) {
+      return false;
+    }
+  }
+}
+
+/*
+  Return false if the pieces left can't possibly make a perfect clear of rows
+  [first, rows).
+ */
+static bool sv_can_clear(sv_search *s, sv_node *n, int first)
+{
+  tetris_solver *sv = s->sv;
+  int r, i, typ, empty = 0, pieces = 0, skew = 0, fixable = 0;
+  uint16_t even = 0x5555 & s->full;
+
+  for (r = first; r < sv->rows; r++) {
+    empty += sv_popcount(~n->board[r] & s->full);
+    skew += sv_popcount(~n->board[r] & even) -
+      sv_popcount(~n->board[r] & ~even & s->full);
+  }
+  // Enough pieces to fill it?
+  for (i = n->next; i <= sv->npieces; i++) {
+    typ = i < sv->npieces ? sv->queue[i] : n->hold;
+    if (typ < 0) {
+      continue;
+    }
+    pieces++;
+    // Column parity: the empty cells in even and odd columns have to even out.
+    // O, S and Z always cover two of each.  T, J and L can cover three of one,
+    // and I four.  Line clears don't change it, since they take away as many
+    // of each.
+    fixable += typ == TET_I ? 4 :
+      typ == TET_J || typ == TET_L || typ == TET_T ? 2 : 0;
+  }
+  if (empty > 4 * pieces || abs(skew) > fixable) {
+    return false;
+  }
+  return sv->exhaustive || sv_areas_ok(s, n->board, first);
+}
+
+/*
+  Return the most lines the pieces left could possibly clear in rows [first,
+  rows): as many of the emptiest rows as they have cells to fill.
+ */
+static int sv_max_lines(sv_search *s, sv_node *n, int first)
+{
+  tetris_solver *sv = s->sv;
+  int count[SV_MAX_COLS + 1] = {0};
+  int r, e, cells, lines = 0;
+
+  cells = TETRIS * (sv->npieces - n->next + (n->hold >= 0));
+  for (r = first; r < sv->rows; r++) {
+    count[sv_popcount(~n->board[r] & s->full)]++;
+  }
+  for (e = 1; e <= sv->cols; e++) {
+    for (; count[e] > 0 && cells >= e; count[e]--, cells -= e) {
+      lines++;
+    }
+  }
+  return lines;
+}
+
+/*******************************************************************************
+
+                                Memoization
+
+*******************************************************************************/
+
+static uint64_t sv_hash(sv_search *s, sv_node *n)
+{
+  uint64_t h = 0xcbf29ce484222325ULL;
+  int r;
+  for (r = 0; r < s->sv->rows; r++) {
+    h = (h ^ n->board[r]) * 0x100000001b3ULL;
+  }
+  h = (h ^ n->next) * 0x100000001b3ULL;
+  h = (h ^ (n->hold + 1)) * 0x100000001b3ULL;
+  h = (h ^ n->lines) * 0x100000001b3ULL;
+  h ^= h >> 29;
+  return h ? h : 1; // zero marks an empty slot
+}
+
+/*
+  Remember a state.  Returns true if it was already there.
+ */
+static bool sv_seen(sv_search *s, sv_node *n)
+{
+  uint64_t h = sv_hash(s, n), old;
+  size_t mask = ((size_t)1 << SV_MEMO_BITS) - 1, i = h & mask;
+  int p;
+  for (p = 0; p < SV_MEMO_PROBES; p++, i = (i + 1) & mask) {
+    old = __atomic_load_n(&s->memo[i], __ATOMIC_RELAXED);
+    if (old == h) {
+      return true;
+    }
+    if (old == 0) {
+      if (__atomic_compare_exchange_n(&s->memo[i], &old, h, false,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        return false;
+      }
+      if (old == h) {
+        return true;
+      }
+    }
+  }
+  return false; // table is full around here; just search it again
+}
+
+/*******************************************************************************
+
+                                   Search
+
+*******************************************************************************/
+
+/*
+  Record a path as the answer, if it's better than the one we have.
+ */
+static void sv_record(sv_search *s, sv_step *path, int depth, int lines,
+                      bool perfect)
+{
+  tetris_solver *sv = s->sv;
+  pthread_mutex_lock(&s->lock);
+  if (!sv->perfect && (perfect || lines > sv->lines ||
+                       (lines == sv->lines && depth < sv->nsteps))) {
+    sv->perfect = perfect;
+    sv->lines = lines;
+    sv->nsteps = depth;
+    memcpy(sv->steps, path, depth * sizeof(sv_step));
+    __atomic_store_n(&s->best, lines, __ATOMIC_RELAXED);
+    if (perfect) {
+      __atomic_store_n(&s->done, true, __ATOMIC_RELAXED);
+    }
+  }
+  pthread_mutex_unlock(&s->lock);
+}
+
+/*
+  Call `visit` for each child of a node: each piece that can be played next
+  (from the queue or from hold), in each orientation and column.
+ */
+typedef void (*sv_visitor)(sv_search *s, void *arg, sv_node *child,
+                           sv_step *step);
+
+static void sv_children(sv_search *s, sv_node *n, sv_visitor visit, void *arg)
+{
+  tetris_solver *sv = s->sv;
+  int choice, typ, o, i, col, row, first, cleared;
+  const sv_shape *sh;
+  sv_node child;
+  sv_step step;
+
+  for (choice = 0; choice < 2; choice++) {
+    // Choice 0 plays the next piece.  Choice 1 presses hold first, and plays
+    // what comes out: the held piece, or if hold is empty, the one after next.
+    // Once the queue runs out, only the held piece is left.
+    child.hold = n->hold;
+    child.next = n->next + 1;
+    if (choice == 0) {
+      if (n->next >= sv->npieces) {
+        continue;
+      }
+      typ = sv->queue[n->next];
+    } else if (n->hold >= 0 && n->next >= sv->npieces) {
+      typ = n->hold;
+      child.hold = -1;
+      child.next = n->next;
+    } else if (n->hold >= 0) {
+      if (n->hold == sv->queue[n->next]) {
+        continue; // same as choice 0
+      }
+      typ = n->hold;
+      child.hold = sv->queue[n->next];
+    } else if (n->next + 1 < sv->npieces) {
+      typ = sv->queue[n->next + 1];
+      child.hold = sv->queue[n->next];
+      child.next = n->next + 2;
+    } else {
+      continue;
+    }
+
+    for (o = 0; o < NUM_ORIENTATIONS; o++) {
+      sh = &SHAPES[typ][o];
+      if (sh->duplicate) {
+        continue;
+      }
+      for (col = 0; col + sh->width <= sv->cols; col++) {
+        if ((row = sv_drop(s, n->board, sh, col)) < 0) {
+          continue;
+        }
+        // For a perfect clear, pieces have to stay in the rows being cleared.
+        first = sv->rows - (sv->height - n->lines);
+        if (sv->height && row < first) {
+          continue;
+        }
+        memcpy(child.board, n->board, sv->rows * sizeof(uint16_t));
+        for (i = 0; i < sh->height; i++) {
+          child.board[row + i] |= sh->mask[i] << col;
+        }
+        cleared = sv_clear(s, child.board, row, row + sh->height - 1);
+        child.lines = n->lines + cleared;
+
+        step.typ = typ;
+        step.ori = o;
+        step.loc.row = row - sh->top;
+        step.loc.col = col - sh->left;
+        step.hold = choice == 1;
+        visit(s, arg, &child, &step);
+      }
+    }
+  }
+}
+
+static void sv_visit(sv_search *s, void *arg, sv_node *child, sv_step *step);
+
+/*
+  Search everything below a node, `depth` placements in.
+ */
+static void sv_search_node(sv_worker *w, sv_node *n, int depth)
+{
+  sv_search *s = w->s;
+  tetris_solver *sv = s->sv;
+  int r, first = sv->height ? sv->rows - (sv->height - n->lines) : 0;
+  bool empty = true;
+  sv_position pos;
+
+  if (__atomic_load_n(&s->done, __ATOMIC_RELAXED)) {
+    return;
+  }
+  w->nodes++;
+
+  for (r = 0; r < sv->rows && empty; r++) {
+    empty = n->board[r] == 0;
+  }
+  if (empty && depth > 0) {
+    sv_record(s, w->path, depth, n->lines, true);
+    return;
+  }
+  if (n->lines > __atomic_load_n(&s->best, __ATOMIC_RELAXED)) {
+    sv_record(s, w->path, depth, n->lines, false);
+  }
+  if (n->next >= sv->npieces && n->hold < 0) {
+    return;
+  }
+  if (sv->height && s->perfect && !sv_can_clear(s, n, first)) {
+    return;
+  }
+  // Without a perfect clear to find, stop when this can't beat the best yet.
+  if (!s->perfect && n->lines + sv_max_lines(s, n, first) <=
+      __atomic_load_n(&s->best, __ATOMIC_RELAXED)) {
+    return;
+  }
+  if (depth > 0 && sv_seen(s, n)) {
+    return;
+  }
+  pos.w = w;
+  pos.depth = depth;
+  sv_children(s, n, sv_visit, &pos);
+}
+
+/*
+  Visitor for the search: go down into a child.  `arg` is the parent's
+  sv_position.
+ */
+static void sv_visit(sv_search *s, void *arg, sv_node *child, sv_step *step)
+{
+  sv_position *pos = arg;
+  (void)s;
+  pos->w->path[pos->depth] = *step;
+  sv_search_node(pos->w, child, pos->depth + 1);
+}
+
+/*
+  Visitor for collecting the first placements.
+ */
+static void sv_collect(sv_search *s, void *arg, sv_node *child, sv_step *step)
+{
+  (void)arg;
+  s->roots[s->nroots] = *child;
+  s->root_steps[s->nroots] = *step;
+  s->nroots++;
+}
+
+/*
+  Thread body: search below first placements until there are none left.
+ */
+static void *sv_thread(void *arg)
+{
+  sv_worker *w = arg;
+  sv_search *s = w->s;
+  int i;
+
+  for (;;) {
+    pthread_mutex_lock(&s->lock);
+    i = s->next_root++;
+    pthread_mutex_unlock(&s->lock);
+    if (i >= s->nroots || __atomic_load_n(&s->done, __ATOMIC_RELAXED)) {
+      break;
+    }
+    w->path[0] = s->root_steps[i];
+    sv_search_node(w, &s->roots[i], 1);
+  }
+  return NULL;
+}
+
+/*******************************************************************************
+
+                                Public API
+
+*******************************************************************************/
+
+/*
+  Start a puzzle with an empty board, no pieces, and default settings.
+ */
+void sv_init(tetris_solver *sv, int rows, int cols)
+{
+  memset(sv, 0, sizeof(tetris_solver));
+  sv->rows = rows;
+  sv->cols = cols;
+  sv->hold = -1;
+  sv->height = 4;
+  sv->threads = 1;
+}
+
+/*
+  Fill a cell of the board.  Returns false if it's out of bounds.
+ */
+bool sv_set(tetris_solver *sv, int row, int col)
+{
+  if (row < 0 || row >= sv->rows || col < 0 || col >= sv->cols) {
+    return false;
+  }
+  sv->board[row] |= 1 << col;
+  return true;
+}
+
+/*
+  Set up a puzzle from a game: its board (without the falling block), the
+  falling and next blocks as the queue, and its hold.
+ */
+void sv_from_game(tetris_solver *sv, tetris_game *obj)
+{
+  int i, j, b;
+  bool falling;
+  tetris_location c;
+
+  sv_init(sv, obj->rows, obj->cols);
+  for (i = 0; i < obj->rows; i++) {
+    for (j = 0; j < obj->cols; j++) {
+      falling = false;
+      for (b = 0; b < TETRIS; b++) {
+        c = TETROMINOS[obj->falling.typ][obj->falling.ori][b];
+        falling |= obj->falling.loc.row + c.row == i &&
+          obj->falling.loc.col + c.col == j;
+      }
+      if (TC_IS_FILLED(tg_get(obj, i, j)) && !falling) {
+        sv_set(sv, i, j);
+      }
+    }
+  }
+  sv->queue[sv->npieces++] = obj->falling.typ;
+  sv->queue[sv->npieces++] = obj->next.typ;
+  sv->hold = obj->stored.typ;
+}
+
+/*
+  Return the tetris_type named by a letter (I, J, L, O, S, T or Z), or -1.
+ */
+int sv_parse_piece(char c)
+{
+  const char *p = memchr(PIECE_NAMES, c >= 'a' ? c - 'a' + 'A' : c,
+                         NUM_TETROMINOS);
+  return c && p ? p - PIECE_NAMES : -1;
+}
+
+char sv_piece_name(int typ)
+{
+  return typ >= 0 && typ < NUM_TETROMINOS ? PIECE_NAMES[typ] : '-';
+}
+
+/*
+  Search the whole tree below the root once, on sv->threads threads, with a
+  fresh memo.
+ */
+static void sv_run(sv_search *s, sv_node *root)
+{
+  tetris_solver *sv = s->sv;
+  sv_worker *workers;
+  pthread_t *threads;
+  int i;
+
+  s->memo = calloc((size_t)1 << SV_MEMO_BITS, sizeof(uint64_t));
+  s->roots = malloc(2 * NUM_ORIENTATIONS * SV_MAX_COLS * sizeof(sv_node));
+  s->root_steps = malloc(2 * NUM_ORIENTATIONS * SV_MAX_COLS * sizeof(sv_step));
+  s->nroots = 0;
+  s->next_root = 0;
+  sv_children(s, root, sv_collect, NULL);
+
+  workers = malloc(sv->threads * sizeof(sv_worker));
+  threads = malloc(sv->threads * sizeof(pthread_t));
+  for (i = 0; i < sv->threads; i++) {
+    workers[i].s = s;
+    workers[i].nodes = 0;
+    pthread_create(&threads[i], NULL, sv_thread, &workers[i]);
+  }
+  for (i = 0; i < sv->threads; i++) {
+    pthread_join(threads[i], NULL);
+    sv->nodes += workers[i].nodes;
+  }
+
+  free(threads);
+  free(workers);
+  free(s->roots);
+  free(s->root_steps);
+  free(s->memo);
+}
+
+/*
+  Solve the puzzle.  Returns true if it found a perfect clear; either way, the
+  best answer found is in sv->steps.
+ */
+bool sv_solve(tetris_solver *sv)
+{
+  static pthread_once_t once = PTHREAD_ONCE_INIT;
+  sv_search s;
+  sv_node root;
+  int r, height = sv->height;
+
+  pthread_once(&once, sv_init_shapes);
+  sv->perfect = false;
+  sv->lines = 0;
+  sv->nsteps = 0;
+  sv->nodes = 0;
+
+  s.sv = sv;
+  s.full = (1 << sv->cols) - 1;
+  s.done = false;
+  s.best = 0;
+  pthread_mutex_init(&s.lock, NULL);
+
+  memcpy(root.board, sv->board, sizeof(root.board));
+  root.next = 0;
+  root.hold = sv->hold;
+  root.lines = 0;
+
+  // A perfect clear needs everything to be in the rows being cleared, and has
+  // to pass the pruning tests.  If it can't, just go for the most lines, in
+  // those rows if possible.
+  for (r = 0; sv->height && r < sv->rows - sv->height; r++) {
+    if (root.board[r]) {
+      sv->height = 0;
+    }
+  }
+  s.perfect = sv->height && sv_can_clear(&s, &root, sv->rows - sv->height);
+  sv_run(&s, &root);
+
+  // Looking for a perfect clear prunes everything that can't make one, so if
+  // there isn't one, the lines found so far aren't necessarily the most.
+  // Search again for those (keeping the best so far, to prune with).
+  if (s.perfect && !sv->perfect) {
+    s.perfect = false;
+    sv_run(&s, &root);
+  }
+
+  pthread_mutex_destroy(&s.lock);
+  sv->height = height;
+  return sv->perfect;
+}
@@ -0,0 +1,91 @@
+/***************************************************************************//**
+
+  @file         solver.h
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Perfect clear and puzzle solver.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "tetris.h"
+
+/*
+  Limits on the puzzles the solver takes.  Each board row is a bit mask.
+ */
+#define SV_MAX_ROWS 64
+#define SV_MAX_COLS 16
+#define SV_MAX_PIECES 32
+
+/*
+  One placement in a solution: which piece goes where, as a tetris_block
+  orientation and location.  `hold` means the hold key is pressed first, so
+  the piece placed is the one that comes out of hold.
+ */
+typedef struct {
+  int typ;
+  int ori;
+  tetris_location loc;
+  bool hold;
+} sv_step;
+
+/*
+  A puzzle, and once it's solved, the answer.
+
+  Pieces come from the queue in order, and the hold slot can swap one out at any
+  time, as in the game.  Pieces are placed by dropping them straight down from
+  the top of the board.
+
+  With `height` set, the solver looks for a perfect clear of the bottom `height`
+  rows: every piece has to stay inside them, and they all have to be cleared.
+  If there is no perfect clear, it searches again for the most lines it can
+  clear with pieces inside those rows.  With `height` zero, it places pieces
+  anywhere, to clear as many lines as possible.
+ */
+typedef struct {
+  /*
+    The puzzle:
+   */
+  int rows;
+  int cols;
+  uint16_t board[SV_MAX_ROWS]; // bit c of board[r] is row r, column c
+  int queue[SV_MAX_PIECES];
+  int npieces;
+  int hold;                    // tetris_type, or -1 for an empty hold
+  int height;
+  /*
+    Search settings.  Unless `exhaustive` is set, areas of the board that can't
+    be filled with whole pieces are pruned.  This is very effective, but it can
+    miss a solution where a line clear joins two areas together.
+   */
+  int threads;
+  bool exhaustive;
+  /*
+    The answer:
+   */
+  bool perfect;
+  int lines;
+  int nsteps;
+  sv_step steps[SV_MAX_PIECES];
+  long long nodes;
+} tetris_solver;
+
+void sv_init(tetris_solver *sv, int rows, int cols);
+bool sv_set(tetris_solver *sv, int row, int col);
+void sv_from_game(tetris_solver *sv, tetris_game *obj);
+int sv_parse_piece(char c);
+char sv_piece_name(int typ);
+bool sv_solve(tetris_solver *sv);
+
+#endif // SOLVER_H
@@ -20,6 +20,7 @@
 #include <time.h>
 
 #include "tetris.h"
+#include "perf.h"
 
 #define MAX(X,Y) ((X) > (Y) ? (X) : (Y))
 #define MIN(X,Y) ((X) < (Y) ? (X) : (Y))
@@ -30,7 +31,7 @@
 
 *******************************************************************************/
 
-tetris_location TETROMINOS[NUM_TETROMINOS][NUM_ORIENTATIONS][TETRIS] = {
+const tetris_location TETROMINOS[NUM_TETROMINOS][NUM_ORIENTATIONS][TETRIS] = {
   // I
   {{{1, 0}, {1, 1}, {1, 2}, {1, 3}},
    {{0, 2}, {1, 2}, {2, 2}, {3, 2}},
@@ -68,11 +69,106 @@ tetris_location TETROMINOS[NUM_TETROMINOS][NUM_ORIENTATIONS][TETRIS] = {
    {{0, 1}, {1, 0}, {1, 1}, {2, 0}}},
 };
 
-int GRAVITY_LEVEL[MAX_LEVEL+1] = {
-// 0,  1,  2,  3,  4,  5,  6,  7,  8,  9,
-  50, 48, 46, 44, 42, 40, 38, 36, 34, 32,
-//10, 11, 12, 13, 14, 15, 16, 17, 18, 19,
-  30, 28, 26, 24, 22, 20, 16, 12,  8,  4
+/*
+  Levels 0-19 fall one cell every 50, 48, ... 8, 4 ticks (rounded up, so the
+  block never falls slower than that).  After that it speeds up to 20G.
+ */
+#define G(cells, ticks) (((cells) * GRAVITY_UNIT + (ticks) - 1) / (ticks))
+const int GRAVITY_LEVEL[MAX_LEVEL+1] = {
+  // 0-9
+  G(1, 50), G(1, 48), G(1, 46), G(1, 44), G(1, 42),
+  G(1, 40), G(1, 38), G(1, 36), G(1, 34), G(1, 32),
+  // 10-19
+  G(1, 30), G(1, 28), G(1, 26), G(1, 24), G(1, 22),
+  G(1, 20), G(1, 16), G(1, 12), G(1, 8),  G(1, 4),
+  // 20-29
+  G(1, 3),  G(1, 2),  G(1, 1),  G(2, 1),  G(3, 1),
+  G(4, 1),  G(5, 1),  G(10, 1), G(15, 1), G(20, 1)
+};
+#undef G
+
+/*
+  One thing to try when rotating: turn the block by some number of quarter turns
+  clockwise, and move it by an offset.
+ */
+typedef struct {
+  int turns;
+  tetris_location offset;
+} tetris_kick;
+
+/*
+  Everything to try for one rotation, in order.  The first that fits wins.
+ */
+#define MAX_KICKS 10
+typedef struct {
+  int count;
+  tetris_kick kicks[MAX_KICKS];
+} tetris_kick_list;
+
+/*
+  Kick tables are indexed by the orientation rotated from, and then by the
+  direction (0 is clockwise, 1 is counter clockwise).
+
+  The classic system tries the next orientation in place, then one column left,
+  then one column right; failing that, it does the same for the orientation
+  after that, and so on.  It doesn't care about the type or orientation.  The
+  last entry is always "don't rotate", which always fits.
+ */
+static const tetris_kick_list CLASSIC_KICKS[2] = {
+  {10, {{1, {0, 0}}, {1, {0, -1}}, {1, {0, 1}},
+        {2, {0, 0}}, {2, {0, -1}}, {2, {0, 1}},
+        {3, {0, 0}}, {3, {0, -1}}, {3, {0, 1}},
+        {0, {0, 0}}}},
+  {10, {{3, {0, 0}}, {3, {0, -1}}, {3, {0, 1}},
+        {2, {0, 0}}, {2, {0, -1}}, {2, {0, 1}},
+        {1, {0, 0}}, {1, {0, -1}}, {1, {0, 1}},
+        {0, {0, 0}}}},
+};
+
+/*
+  SRS kicks for J, L, S, T and Z.
+ */
+static const tetris_kick_list SRS_KICKS[NUM_ORIENTATIONS][2] = {
+  // 0->R, 0->L
+  {{5, {{1, {0, 0}}, {1, {0, -1}}, {1, {-1, -1}}, {1, {2, 0}}, {1, {2, -1}}}},
+   {5, {{3, {0, 0}}, {3, {0, 1}}, {3, {-1, 1}}, {3, {2, 0}}, {3, {2, 1}}}}},
+  // R->2, R->0
+  {{5, {{1, {0, 0}}, {1, {0, 1}}, {1, {1, 1}}, {1, {-2, 0}}, {1, {-2, 1}}}},
+   {5, {{3, {0, 0}}, {3, {0, 1}}, {3, {1, 1}}, {3, {-2, 0}}, {3, {-2, 1}}}}},
+  // 2->L, 2->R
+  {{5, {{1, {0, 0}}, {1, {0, 1}}, {1, {-1, 1}}, {1, {2, 0}}, {1, {2, 1}}}},
+   {5, {{3, {0, 0}}, {3, {0, -1}}, {3, {-1, -1}}, {3, {2, 0}}, {3, {2, -1}}}}},
+  // L->0, L->2
+  {{5, {{1, {0, 0}}, {1, {0, -1}}, {1, {1, -1}}, {1, {-2, 0}}, {1, {-2, -1}}}},
+   {5, {{3, {0, 0}}, {3, {0, -1}}, {3, {1, -1}}, {3, {-2, 0}}, {3, {-2, -1}}}}},
+};
+
+/*
+  SRS kicks for I.  Our I sits one row lower in orientation 2 than it does in
+  SRS, so rotations into 2 have an extra row up, and rotations out of 2 an extra
+  row down.
+ */
+static const tetris_kick_list SRS_I_KICKS[NUM_ORIENTATIONS][2] = {
+  // 0->R, 0->L
+  {{5, {{1, {0, 0}}, {1, {0, -2}}, {1, {0, 1}}, {1, {1, -2}}, {1, {-2, 1}}}},
+   {5, {{3, {0, 0}}, {3, {0, -1}}, {3, {0, 2}}, {3, {-2, -1}}, {3, {1, 2}}}}},
+  // R->2, R->0
+  {{5, {{1, {-1, 0}}, {1, {-1, -1}}, {1, {-1, 2}}, {1, {-3, -1}}, {1, {0, 2}}}},
+   {5, {{3, {0, 0}}, {3, {0, 2}}, {3, {0, -1}}, {3, {-1, 2}}, {3, {2, -1}}}}},
+  // 2->L, 2->R
+  {{5, {{1, {1, 0}}, {1, {1, 2}}, {1, {1, -1}}, {1, {0, 2}}, {1, {3, -1}}}},
+   {5, {{3, {1, 0}}, {3, {1, 1}}, {3, {1, -2}}, {3, {3, 1}}, {3, {0, -2}}}}},
+  // L->0, L->2
+  {{5, {{1, {0, 0}}, {1, {0, 1}}, {1, {0, -2}}, {1, {2, 1}}, {1, {-1, -2}}}},
+   {5, {{3, {-1, 0}}, {3, {-1, -2}}, {3, {-1, 1}}, {3, {0, -2}}, {3, {-3, 1}}}}},
+};
+
+/*
+  SRS doesn't kick O at all.
+ */
+static const tetris_kick_list SRS_O_KICKS[2] = {
+  {1, {{1, {0, 0}}}},
+  {1, {{3, {0, 0}}}},
 };
 
 /*******************************************************************************
@@ -81,20 +177,48 @@ int GRAVITY_LEVEL[MAX_LEVEL+1] = {
 
 *******************************************************************************/
 
+/*
+  Return where row `row` of the board is stored.
+ */
+static int tg_slot(tetris_game *obj, int row)
+{
+  int i = obj->row_head + row;
+  return obj->row_index[i < obj->rows ? i : i - obj->rows];
+}
+
+/*
+  Return the cells of a row of the board.
+ */
+char *tg_row(tetris_game *obj, int row)
+{
+  return obj->board + obj->cols * tg_slot(obj, row);
+}
+
 /*
    Return the block at the given row and column.
  */
 char tg_get(tetris_game *obj, int row, int column)
 {
-  return obj->board[obj->cols * row + column];
+  return tg_row(obj, row)[column];
 }
 
 /*
   Set the block at the given row and column.
  */
-static void tg_set(tetris_game *obj, int row, int column, char value)
+void tg_set(tetris_game *obj, int row, int column, char value)
 {
-  obj->board[obj->cols * row + column] = value;
+  int slot = tg_slot(obj, row);
+  char *cell = obj->board + obj->cols * slot + column;
+  if (TC_IS_EMPTY(*cell) && TC_IS_FILLED(value)) {
+    if (++obj->row_fill[slot] == obj->cols) {
+      obj->full_rows++;
+    }
+  } else if (TC_IS_FILLED(*cell) && TC_IS_EMPTY(value)) {
+    if (obj->row_fill[slot]-- == obj->cols) {
+      obj->full_rows--;
+    }
+  }
+  *cell = value;
 }
 
 /*
@@ -136,6 +260,7 @@ static void tg_remove(tetris_game *obj, tetris_block block)
 static bool tg_fits(tetris_game *obj, tetris_block block)
 {
   int i, r, c;
+  PF_COUNT(PF_FITS);
   for (i = 0; i < TETRIS; i++) {
     tetris_location cell = TETROMINOS[block.typ][block.ori][i];
     r = block.loc.row + cell.row;
@@ -148,10 +273,15 @@ static bool tg_fits(tetris_game *obj, tetris_block block)
 }
 
 /*
-  Return a random tetromino type.
+  Return a random tetromino type, advancing the game's xorshift generator.
  */
-static int random_tetromino(void) {
-  return rand() % NUM_TETROMINOS;
+static int random_tetromino(tetris_game *obj) {
+  uint32_t x = obj->rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  obj->rng = x;
+  return x % NUM_TETROMINOS;
 }
 
 /*
@@ -162,7 +292,7 @@ static void tg_new_falling(tetris_game *obj)
 {
   // Put in a new falling tetromino.
   obj->falling = obj->next;
-  obj->next.typ = random_tetromino();
+  obj->next.typ = random_tetromino(obj);
   obj->next.ori = 0;
   obj->next.loc.row = 0;
   obj->next.loc.col = obj->cols/2 - 2;
@@ -175,24 +305,57 @@ static void tg_new_falling(tetris_game *obj)
 *******************************************************************************/
 
 /*
-  Tick gravity, and move the block down if gravity should act.
+  Return how many rows the falling block could move down, up to `limit`.  The
+  block must be removed from the board first.  Limiting it keeps gravity from
+  looking all the way down a tall board when it only moves a row.
+ */
+static int tg_drop_distance(tetris_game *obj, int limit)
+{
+  int i, r, c, d, distance = limit;
+  for (i = 0; i < TETRIS; i++) {
+    tetris_location cell = TETROMINOS[obj->falling.typ][obj->falling.ori][i];
+    r = obj->falling.loc.row + cell.row;
+    c = obj->falling.loc.col + cell.col;
+    for (d = 0; d < distance; d++) {
+      if (!tg_check(obj, r + d + 1, c) ||
+          TC_IS_FILLED(tg_get(obj, r + d + 1, c)))
+        break;
+    }
+    distance = d;
+  }
+  return distance;
+}
+
+/*
+  Tick gravity, and move the block down if gravity should act.  When gravity
+  adds up to several rows in one tick, the block falls as far as it can, up to
+  that many.  A block that is already resting on something locks instead, and
+  the next one falls a row on the very next tick (as it always has), so gravity
+  is topped up to a whole row by then.
  */
 static void tg_do_gravity_tick(tetris_game *obj)
 {
-  obj->ticks_till_gravity--;
-  if (obj->ticks_till_gravity <= 0) {
-    tg_remove(obj, obj->falling);
-    obj->falling.loc.row++;
-    if (tg_fits(obj, obj->falling)) {
-      obj->ticks_till_gravity = GRAVITY_LEVEL[obj->level];
-    } else {
-      obj->falling.loc.row--;
-      tg_put(obj, obj->falling);
+  int rows, distance;
 
-      tg_new_falling(obj);
-    }
+  obj->gravity_acc += GRAVITY_LEVEL[obj->level];
+  if (obj->gravity_acc < GRAVITY_UNIT) {
+    return;
+  }
+  rows = obj->gravity_acc / GRAVITY_UNIT;
+  obj->gravity_acc %= GRAVITY_UNIT;
+
+  tg_remove(obj, obj->falling);
+  distance = tg_drop_distance(obj, MIN(rows, obj->rows));
+  if (distance > 0) {
+    obj->falling.loc.row += distance;
+  } else {
     tg_put(obj, obj->falling);
+    tg_new_falling(obj);
+    obj->gravity_acc = MAX(obj->gravity_acc,
+                           GRAVITY_UNIT - GRAVITY_LEVEL[obj->level]);
+    obj->events |= TE_LOCK;
   }
+  tg_put(obj, obj->falling);
 }
 
 /*
@@ -214,49 +377,60 @@ static void tg_move(tetris_game *obj, int direction)
 static void tg_down(tetris_game *obj)
 {
   tg_remove(obj, obj->falling);
-  while (tg_fits(obj, obj->falling)) {
-    obj->falling.loc.row++;
-  }
-  obj->falling.loc.row--;
+  obj->falling.loc.row += tg_drop_distance(obj, obj->rows);
   tg_put(obj, obj->falling);
   tg_new_falling(obj);
+  obj->events |= TE_LOCK;
 }
 
 /*
-  Rotate the falling block in either direction (+/-1).
+  Return the kicks to try when rotating the falling block in either direction
+  (+/-1), under the game's rotation system.
  */
-static void tg_rotate(tetris_game *obj, int direction)
+static const tetris_kick_list *tg_kicks(tetris_game *obj, int direction)
 {
-  tg_remove(obj, obj->falling);
-
-  while (true) {
-    obj->falling.ori = (obj->falling.ori + direction) % NUM_ORIENTATIONS;
+  int dir = direction < 0;
+  if (obj->rotation == TR_CLASSIC) {
+    return &CLASSIC_KICKS[dir];
+  } else if (obj->falling.typ == TET_I) {
+    return &SRS_I_KICKS[obj->falling.ori][dir];
+  } else if (obj->falling.typ == TET_O) {
+    return &SRS_O_KICKS[dir];
+  } else {
+    return &SRS_KICKS[obj->falling.ori][dir];
+  }
+}
 
-    // If the new orientation fits, we're done.
-    if (tg_fits(obj, obj->falling))
-      break;
+/*
+  Rotate the falling block in either direction (+/-1).  Tries each kick in turn,
+  and leaves the block alone if none of them fit.
+ */
+static void tg_rotate(tetris_game *obj, int direction)
+{
+  const tetris_kick_list *list = tg_kicks(obj, direction);
+  tetris_block orig = obj->falling;
+  int i;
 
-    // Otherwise, try moving left to make it fit.
-    obj->falling.loc.col--;
-    if (tg_fits(obj, obj->falling))
-      break;
+  tg_remove(obj, obj->falling);
 
-    // Finally, try moving right to make it fit.
-    obj->falling.loc.col += 2;
+  for (i = 0; i < list->count; i++) {
+    const tetris_kick *kick = &list->kicks[i];
+    obj->falling.ori = (orig.ori + kick->turns) % NUM_ORIENTATIONS;
+    obj->falling.loc.row = orig.loc.row + kick->offset.row;
+    obj->falling.loc.col = orig.loc.col + kick->offset.col;
     if (tg_fits(obj, obj->falling))
       break;
-
-    // Put it back in its original location and try the next orientation.
-    obj->falling.loc.col--;
-    // Worst case, we come back to the original orientation and it fits, so this
-    // loop will terminate.
+  }
+  if (i == list->count) {
+    obj->falling = orig;
   }
 
   tg_put(obj, obj->falling);
 }
 
 /*
-  Swap the falling block with the block in the hold buffer.
+  Swap the falling block with the block in the hold buffer.  If the held block
+  doesn't fit anywhere above the falling one, nothing happens.
  */
 static void tg_hold(tetris_game *obj)
 {
@@ -265,13 +439,20 @@ static void tg_hold(tetris_game *obj)
     obj->stored = obj->falling;
     tg_new_falling(obj);
   } else {
-    int typ = obj->falling.typ, ori = obj->falling.ori;
+    tetris_block orig = obj->falling;
     obj->falling.typ = obj->stored.typ;
     obj->falling.ori = obj->stored.ori;
-    obj->stored.typ = typ;
-    obj->stored.ori = ori;
+    obj->stored.typ = orig.typ;
+    obj->stored.ori = orig.ori;
     while (!tg_fits(obj, obj->falling)) {
       obj->falling.loc.row--;
+      // Blocks can't stick out of the top, so this is as high as we can go.
+      if (obj->falling.loc.row < -TETRIS) {
+        obj->stored.typ = obj->falling.typ;
+        obj->stored.ori = obj->falling.ori;
+        obj->falling = orig;
+        break;
+      }
     }
   }
   tg_put(obj, obj->falling);
@@ -312,25 +493,41 @@ static void tg_handle_move(tetris_game *obj, tetris_move move)
  */
 static bool tg_line_full(tetris_game *obj, int i)
 {
-  int j;
-  for (j = 0; j < obj->cols; j++) {
-    if (TC_IS_EMPTY(tg_get(obj, i, j)))
-      return false;
-  }
-  return true;
+  return obj->row_fill[tg_slot(obj, i)] == obj->cols;
 }
 
 /*
-  Shift every row above r down one.
+  Index of row i in row_index.
  */
-static void tg_shift_lines(tetris_game *obj, int r)
+#define TG_RING(obj, i) (((obj)->row_head + (i)) % (obj)->rows)
+
+/*
+  Remove row r, shifting every row above it down one, and leaving an empty row
+  at the top.  Only the row indices on the shorter side of r move: either the
+  rows above shift down, or the rows below shift up and the top of the ring
+  moves back one.
+ */
+static void tg_clear_line(tetris_game *obj, int r)
 {
-  int i, j;
-  for (i = r-1; i >= 0; i--) {
-    for (j = 0; j < obj->cols; j++) {
-      tg_set(obj, i+1, j, tg_get(obj, i, j));
-      tg_set(obj, i, j, TC_EMPTY);
+  int i, slot = tg_slot(obj, r);
+
+  memset(obj->board + obj->cols * slot, TC_EMPTY, obj->cols);
+  if (obj->row_fill[slot] == obj->cols) {
+    obj->full_rows--;
+  }
+  obj->row_fill[slot] = 0;
+
+  if (r < obj->rows - 1 - r) {
+    for (i = r; i > 0; i--) {
+      obj->row_index[TG_RING(obj, i)] = obj->row_index[TG_RING(obj, i - 1)];
+    }
+    obj->row_index[TG_RING(obj, 0)] = slot;
+  } else {
+    for (i = r; i < obj->rows - 1; i++) {
+      obj->row_index[TG_RING(obj, i)] = obj->row_index[TG_RING(obj, i + 1)];
     }
+    obj->row_index[TG_RING(obj, obj->rows - 1)] = slot;
+    obj->row_head = TG_RING(obj, obj->rows - 1);
   }
 }
 
@@ -343,9 +540,9 @@ static int tg_check_lines(tetris_game *obj)
   int i, nlines = 0;
   tg_remove(obj, obj->falling); // don't want to mess up falling block
 
-  for (i = obj->rows-1; i >= 0; i--) {
+  for (i = obj->rows-1; i >= 0 && obj->full_rows > 0; i--) {
     if (tg_line_full(obj, i)) {
-      tg_shift_lines(obj, i);
+      tg_clear_line(obj, i);
       i++; // do this line over again since they're shifted
       nlines++;
     }
@@ -360,9 +557,15 @@ static int tg_check_lines(tetris_game *obj)
  */
 static void tg_adjust_score(tetris_game *obj, int lines_cleared)
 {
-  static int line_multiplier[] = {0, 40, 100, 300, 1200};
+  static const int line_multiplier[] = {0, 40, 100, 300, 1200};
   obj->points += line_multiplier[lines_cleared] * (obj->level + 1);
+  if (lines_cleared > 0) {
+    obj->events |= TE_CLEAR;
+  }
   if (lines_cleared >= obj->lines_remaining) {
+    if (obj->level < MAX_LEVEL) {
+      obj->events |= TE_LEVEL;
+    }
     obj->level = MIN(MAX_LEVEL, obj->level + 1);
     lines_cleared -= obj->lines_remaining;
     obj->lines_remaining = LINES_PER_LEVEL - lines_cleared;
@@ -403,40 +606,144 @@ static bool tg_game_over(tetris_game *obj)
 bool tg_tick(tetris_game *obj, tetris_move move)
 {
   int lines_cleared;
+  bool over;
+  PF_BEGIN(PF_TICK);
+  obj->events = 0;
+
   // Handle gravity.
+  PF_BEGIN(PF_GRAVITY);
   tg_do_gravity_tick(obj);
+  PF_END(PF_GRAVITY);
 
   // Handle input.
+  PF_BEGIN(PF_MOVE);
   tg_handle_move(obj, move);
+  PF_END(PF_MOVE);
 
   // Check for cleared lines
+  PF_BEGIN(PF_LINES);
   lines_cleared = tg_check_lines(obj);
+  obj->lines_cleared = lines_cleared;
+  PF_END(PF_LINES);
 
+  PF_BEGIN(PF_SCORE);
   tg_adjust_score(obj, lines_cleared);
+  PF_END(PF_SCORE);
+
+  PF_BEGIN(PF_GAME_OVER);
+  over = tg_game_over(obj);
+  PF_END(PF_GAME_OVER);
 
   // Return whether the game will continue (NOT whether it's over)
-  return !tg_game_over(obj);
+  PF_END(PF_TICK);
+  return !over;
+}
+
+/*
+  Do up to `ticks` ticks with no input, as that many tg_tick(obj, TM_NONE) calls
+  would, but without simulating the ones in between that only add up gravity.
+  Stops early after a tick where the falling block locks (so that a bot can
+  pick its next move) or the game ends.  Returns the number of ticks done, and
+  sets *running to what the last of them would have returned.
+ */
+int tg_idle(tetris_game *obj, int ticks, bool *running)
+{
+  int64_t g, acc, reach, lock, t, fall;
+  int drop, done;
+
+  if (ticks <= 0) {
+    *running = !tg_game_over(obj);
+    return 0;
+  }
+
+  // One whole tick first, so that no lines are left to clear and we know the
+  // game is still going.  After that, nothing but gravity happens until the
+  // block locks.
+  *running = tg_tick(obj, TM_NONE);
+  done = 1;
+  if (!*running || (obj->events & TE_LOCK) || done == ticks) {
+    return done;
+  }
+
+  // Gravity (never zero) has added up to (acc + t*g) / GRAVITY_UNIT rows after
+  // t more ticks, and the block falls that far, up to `drop` rows.  It has
+  // reached the bottom after `reach` ticks, and locks on the next tick gravity
+  // acts.  The first tick may have cleared lines and raised the level, so g is
+  // only read now.
+  g = GRAVITY_LEVEL[obj->level];
+  acc = obj->gravity_acc;
+  tg_remove(obj, obj->falling);
+  drop = tg_drop_distance(obj, obj->rows);
+  reach = drop == 0 ? 0 : ((int64_t)drop * GRAVITY_UNIT - acc + g - 1) / g;
+  lock = (((acc + reach * g) / GRAVITY_UNIT + 1) * GRAVITY_UNIT - acc + g - 1)
+    / g;
+
+  t = MIN(ticks - done, lock - 1);
+  fall = MIN(drop, (acc + t * g) / GRAVITY_UNIT);
+  obj->falling.loc.row += fall;
+  obj->gravity_acc = (acc + t * g) % GRAVITY_UNIT;
+  tg_put(obj, obj->falling);
+  done += t;
+  if (t > 0) {
+    obj->events = 0;
+    obj->lines_cleared = 0;
+  }
+
+  // The tick that locks the block is a whole one again.
+  if (done < ticks) {
+    *running = tg_tick(obj, TM_NONE);
+    done++;
+  }
+  return done;
 }
 
 void tg_init(tetris_game *obj, int rows, int cols)
+{
+  tg_init_seed(obj, rows, cols, time(NULL));
+}
+
+/*
+  Empty the board, and put its rows back in order.
+ */
+static void tg_clear_board(tetris_game *obj)
+{
+  int i;
+  memset(obj->board, TC_EMPTY, obj->rows * obj->cols);
+  for (i = 0; i < obj->rows; i++) {
+    obj->row_index[i] = i;
+    obj->row_fill[i] = 0;
+  }
+  obj->row_head = 0;
+  obj->full_rows = 0;
+}
+
+/*
+  Initialize a game whose sequence of tetrominos is determined by the seed.
+ */
+void tg_init_seed(tetris_game *obj, int rows, int cols, uint32_t seed)
 {
   // Initialization logic
   obj->rows = rows;
   obj->cols = cols;
   obj->board = malloc(rows * cols);
-  memset(obj->board, TC_EMPTY, rows * cols);
+  obj->row_index = malloc(rows * sizeof(int));
+  obj->row_fill = malloc(rows * sizeof(int));
+  tg_clear_board(obj);
   obj->points = 0;
   obj->level = 0;
-  obj->ticks_till_gravity = GRAVITY_LEVEL[obj->level];
+  obj->gravity_acc = 0;
   obj->lines_remaining = LINES_PER_LEVEL;
-  srand(time(NULL));
+  obj->events = 0;
+  obj->lines_cleared = 0;
+  obj->rotation = TR_CLASSIC;
+  obj->rng = seed ? seed : 1; // xorshift gets stuck on zero
   tg_new_falling(obj);
   tg_new_falling(obj);
   obj->stored.typ = -1;
   obj->stored.ori = 0;
   obj->stored.loc.row = 0;
+  obj->stored.loc.col = 0;
   obj->next.loc.col = obj->cols/2 - 2;
-  printf("%d", obj->falling.loc.col);
 }
 
 tetris_game *tg_create(int rows, int cols)
@@ -446,10 +753,19 @@ tetris_game *tg_create(int rows, int cols)
   return obj;
 }
 
+tetris_game *tg_create_seed(int rows, int cols, uint32_t seed)
+{
+  tetris_game *obj = malloc(sizeof(tetris_game));
+  tg_init_seed(obj, rows, cols, seed);
+  return obj;
+}
+
 void tg_destroy(tetris_game *obj)
 {
   // Cleanup logic
   free(obj->board);
+  free(obj->row_index);
+  free(obj->row_fill);
 }
 
 void tg_delete(tetris_game *obj) {
@@ -457,25 +773,57 @@ void tg_delete(tetris_game *obj) {
   free(obj);
 }
 
+/*
+  Copy the state of one game into another of the same size, without allocating.
+ */
+void tg_copy(tetris_game *dst, tetris_game *src)
+{
+  char *board = dst->board;
+  int *row_index = dst->row_index, *row_fill = dst->row_fill;
+  *dst = *src;
+  dst->board = board;
+  dst->row_index = row_index;
+  dst->row_fill = row_fill;
+  memcpy(board, src->board, src->rows * src->cols);
+  memcpy(row_index, src->row_index, src->rows * sizeof(int));
+  memcpy(row_fill, src->row_fill, src->rows * sizeof(int));
+}
+
 /*
   Load a game from a file.
  */
 tetris_game *tg_load(FILE *f)
 {
+  int i, j;
+  char *row;
   tetris_game *obj = malloc(sizeof(tetris_game));
   fread(obj, sizeof(tetris_game), 1, f);
   obj->board = malloc(obj->rows * obj->cols);
-  fread(obj->board, sizeof(char), obj->rows * obj->cols, f);
+  obj->row_index = malloc(obj->rows * sizeof(int));
+  obj->row_fill = malloc(obj->rows * sizeof(int));
+  tg_clear_board(obj);
+  row = malloc(obj->cols);
+  for (i = 0; i < obj->rows; i++) {
+    fread(row, sizeof(char), obj->cols, f);
+    for (j = 0; j < obj->cols; j++) {
+      tg_set(obj, i, j, row[j]);
+    }
+  }
+  free(row);
   return obj;
 }
 
 /*
-  Save a game to a file.
+  Save a game to a file.  Rows are written in order, so the file doesn't depend
+  on how they happen to be stored.
  */
 void tg_save(tetris_game *obj, FILE *f)
 {
+  int i;
   fwrite(obj, sizeof(tetris_game), 1, f);
-  fwrite(obj->board, sizeof(char), obj->rows * obj->cols, f);
+  for (i = 0; i < obj->rows; i++) {
+    fwrite(tg_row(obj, i), sizeof(char), obj->cols, f);
+  }
 }
 
 /*
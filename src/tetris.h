@@ -18,6 +18,7 @@
 
 #include <stdio.h> // for FILE
 #include <stdbool.h> // for bool
+#include <stdint.h> // for uint32_t
 
 /*
   Convert a tetromino type to its corresponding cell.
@@ -52,9 +53,15 @@
 /*
   Level constants.
  */
-#define MAX_LEVEL 19
+#define MAX_LEVEL 29
 #define LINES_PER_LEVEL 10
 
+/*
+  Gravity is measured in fractions of a cell per tick.  This many of them make
+  one cell per tick (1G).
+ */
+#define GRAVITY_UNIT 65536
+
 /*
   A "cell" is a 1x1 block within a tetris board.
  */
@@ -95,16 +102,44 @@ typedef enum {
   TM_LEFT, TM_RIGHT, TM_CLOCK, TM_COUNTER, TM_DROP, TM_HOLD, TM_NONE
 } tetris_move;
 
+/*
+  Rotation systems: what to try when a rotated block doesn't fit where it is.
+  TR_CLASSIC nudges it left or right, or else turns it further.  TR_SRS uses
+  the wall kicks of the Super Rotation System.
+ */
+typedef enum {
+  TR_CLASSIC, TR_SRS
+} tetris_rotation;
+
+/*
+  Things that can happen during a tick.  These are flags, so several can happen
+  on the same tick.
+ */
+typedef enum {
+  TE_LOCK = 1,  // the falling block landed and a new one started falling
+  TE_CLEAR = 2, // one or more lines were cleared
+  TE_LEVEL = 4  // the level went up
+} tetris_event;
+
 /*
   A game object!
  */
 typedef struct {
   /*
-    Game board stuff:
+    Game board stuff.  Rows aren't stored in order: row i of the board is
+    stored in row row_index[(row_head + i) % rows] of `board`.  Clearing a line
+    just moves its storage to the top and shifts indices, instead of copying
+    every row above it down.  row_fill counts the filled cells of each stored
+    row, and full_rows counts the rows that are full, so that finding full
+    lines doesn't have to look at the whole board.
    */
   int rows;
   int cols;
   char *board;
+  int *row_index;
+  int row_head;
+  int *row_fill;
+  int full_rows;
   /*
     Scoring information:
    */
@@ -118,13 +153,30 @@ typedef struct {
   tetris_block next;
   tetris_block stored;
   /*
-    Number of game ticks until the block will move down.
+    How far the falling block has fallen since it last moved down, in units of
+    1/GRAVITY_UNIT cells.
    */
-  int ticks_till_gravity;
+  int gravity_acc;
   /*
     Number of lines until you advance to the next level.
    */
   int lines_remaining;
+  /*
+    State of the random number generator that picks tetrominos.  Each game has
+    its own, so that games are reproducible from their seed and several games
+    can run on different threads.
+   */
+  uint32_t rng;
+  /*
+    What happened on the last tick: tetris_event flags OR'd together, and how
+    many lines were cleared.
+   */
+  int events;
+  int lines_cleared;
+  /*
+    Rotation system (a tetris_rotation) used for this game.
+   */
+  int rotation;
 } tetris_game;
 
 /*
@@ -134,26 +186,33 @@ typedef struct {
   array contains 4 tetris_location objects, each mapping to an offset from a
   point on the upper left that is the tetromino "origin".
  */
-extern tetris_location TETROMINOS[NUM_TETROMINOS][NUM_ORIENTATIONS][TETRIS];
+extern const tetris_location TETROMINOS[NUM_TETROMINOS][NUM_ORIENTATIONS][TETRIS];
 
 /*
-  This array tells you how many ticks per gravity by level.  Decreases as level
-  increases, to add difficulty.
+  This array tells you how fast blocks fall at each level, in 1/GRAVITY_UNIT
+  cells per tick.  Increases as level increases, to add difficulty, up to 20G
+  (instant drop on a normal sized board).
  */
-extern int GRAVITY_LEVEL[MAX_LEVEL+1];
+extern const int GRAVITY_LEVEL[MAX_LEVEL+1];
 
 // Data structure manipulation.
 void tg_init(tetris_game *obj, int rows, int cols);
+void tg_init_seed(tetris_game *obj, int rows, int cols, uint32_t seed);
 tetris_game *tg_create(int rows, int cols);
+tetris_game *tg_create_seed(int rows, int cols, uint32_t seed);
 void tg_destroy(tetris_game *obj);
 void tg_delete(tetris_game *obj);
+void tg_copy(tetris_game *dst, tetris_game *src);
 tetris_game *tg_load(FILE *f);
 void tg_save(tetris_game *obj, FILE *f);
 
 // Public methods not related to memory:
 char tg_get(tetris_game *obj, int row, int col);
+char *tg_row(tetris_game *obj, int row);
+void tg_set(tetris_game *obj, int row, int col, char value);
 bool tg_check(tetris_game *obj, int row, int col);
 bool tg_tick(tetris_game *obj, tetris_move move);
+int tg_idle(tetris_game *obj, int ticks, bool *running);
 void tg_print(tetris_game *obj, FILE *f);
 
 #endif // TETRIS_H
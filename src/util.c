@@ -15,7 +15,11 @@
 
 #define _POSIX_C_SOURCE 199309L
 
-#include <time.h>    // nanosleep
+#include <time.h>    // nanosleep, clock_gettime
+#include <string.h>  // strcmp
+
+#include "tetris.h"
+#include "util.h"
 
 
 void sleep_milli(int milliseconds)
@@ -25,3 +29,48 @@ void sleep_milli(int milliseconds)
   ts.tv_nsec = milliseconds * 1000 * 1000;
   nanosleep(&ts, NULL);
 }
+
+/*
+  Return the time on a monotonic clock, in milliseconds.
+ */
+long clock_milli(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000L + ts.tv_nsec / (1000 * 1000);
+}
+
+/*
+  Return the time on a monotonic clock, in microseconds.
+ */
+long clock_micro(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+/*
+  Sleep until clock_milli() reaches the deadline.  Returns immediately if it
+  already has.
+ */
+void sleep_until_milli(long deadline)
+{
+  long remaining = deadline - clock_milli();
+  if (remaining > 0) {
+    sleep_milli(remaining);
+  }
+}
+
+/*
+  Return the rotation system with the given name, or -1 if there isn't one.
+ */
+int parse_rotation(const char *name)
+{
+  if (strcmp(name, "classic") == 0) {
+    return TR_CLASSIC;
+  } else if (strcmp(name, "srs") == 0) {
+    return TR_SRS;
+  }
+  return -1;
+}
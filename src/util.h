@@ -17,5 +17,9 @@
 #define UTIL_H
 
 void sleep_milli(int milliseconds);
+long clock_milli(void);
+long clock_micro(void);
+void sleep_until_milli(long deadline);
+int parse_rotation(const char *name);
 
 #endif // UTIL_H
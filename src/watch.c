@@ -0,0 +1,152 @@
+/***************************************************************************//**
+
+  @file         watch.c
+
+  @author       Stephen Brennan
+
+  @date         Created Monday, 19 October 2026
+
+  @brief        Watch (or play) a running game through shared memory.
+
+  @copyright    Copyright (c) 2015, Stephen Brennan.  Released under the Revised
+                BSD License.  See LICENSE.txt for details.
+
+*******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>  // getopt
+
+#include "tetris.h"
+#include "share.h"
+#include "bot.h"
+#include "util.h"
+
+/*
+  How often to look at the game.
+ */
+#define POLL_MILLIS 2
+
+/*
+  Print the board, as tg_print() does.
+ */
+static void print_board(tetris_share *sh, const char *board)
+{
+  int i, j;
+  for (i = 0; i < sh->seg->rows; i++) {
+    putchar('|');
+    for (j = 0; j < sh->seg->cols; j++) {
+      fputs(TC_IS_EMPTY(board[i * sh->seg->cols + j]) ? TC_EMPTY_STR
+            : TC_BLOCK_STR, stdout);
+    }
+    puts("|");
+  }
+}
+
+/*
+  Load a snapshot into a game, so the bot can look at it.
+ */
+static void load_game(tetris_game *obj, sh_state *state, const char *board,
+                      uint32_t *locks)
+{
+  int i, j;
+  // The bot plans again for each new block, so tell it when one starts.
+  obj->events = state->locks != *locks ? TE_LOCK : 0;
+  *locks = state->locks;
+  obj->falling = state->falling;
+  obj->next = state->next;
+  obj->stored = state->stored;
+  obj->points = state->points;
+  obj->level = state->level;
+  obj->rotation = state->rotation;
+  for (i = 0; i < obj->rows; i++) {
+    for (j = 0; j < obj->cols; j++) {
+      tg_set(obj, i, j, board[i * obj->cols + j]);
+    }
+  }
+}
+
+static void usage(void)
+{
+  fprintf(stderr, "usage: watch [-b] [-p] [name]\n"
+          "  -b  print the board too\n"
+          "  -p  play the game with the bot, through its input channel\n");
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+  tetris_share sh;
+  sh_state state;
+  tetris_game game;
+  tetris_bot bot;
+  char *board, *name = "/tetris";
+  bool show_board = false, play = false;
+  uint32_t seq, last = 1, locks = 0;
+  int opt, level = -1;
+  tetris_move move;
+
+  while ((opt = getopt(argc, argv, "bp")) != -1) {
+    switch (opt) {
+    case 'b': show_board = true; break;
+    case 'p': play = true; break;
+    default: usage();
+    }
+  }
+  if (optind < argc) {
+    name = argv[optind];
+  }
+
+  if (sh_open(&sh, name) < 0) {
+    fprintf(stderr, "watch: no game published as \"%s\"\n", name);
+    return EXIT_FAILURE;
+  }
+  board = malloc(sh.seg->rows * sh.seg->cols);
+  if (play) {
+    tg_init_seed(&game, sh.seg->rows, sh.seg->cols, 1);
+    bot_init(&bot, &game);
+  }
+
+  do {
+    seq = sh_snapshot(&sh, &state, board);
+    if (seq == last) {
+      sleep_milli(POLL_MILLIS);
+      continue;
+    }
+    last = seq;
+
+    if (show_board) {
+      printf("\033[H");
+      print_board(&sh, board);
+    }
+    if (show_board || state.level != level) {
+      printf("tick %llu: %d points, level %d, %d lines to go\n",
+             (unsigned long long)state.tick, state.points, state.level,
+             state.lines_remaining);
+      fflush(stdout);
+      level = state.level;
+    }
+
+    // Send the bot's move, once the game has taken the last one.
+    if (play && sh.seg->input_head == sh.seg->input_tail) {
+      load_game(&game, &state, board, &locks);
+      move = bot_move(&bot, &game);
+      if (move != TM_NONE) {
+        sh_send_move(&sh, move);
+      }
+    }
+  } while (state.running);
+
+  printf("Game over: %d points on level %d.\n", state.points, state.level);
+  if (play) {
+    bot_destroy(&bot);
+    tg_destroy(&game);
+  }
+  free(board);
+  sh_close(&sh);
+  return EXIT_SUCCESS;
+}